@@ -0,0 +1,101 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include <cstdlib>             // for strtoull
+#include <vector>              // for vector
+#include "AlcPacket.h"         // for AlcPacket
+#include "AlcPacketView.h"     // for AlcPacketView
+#include "EncodingSymbol.h"    // for EncodingSymbol
+#include "bench_utils.h"       // for run, do_not_optimize
+#include "flute_types.h"       // for FecOti, FecScheme
+#include "spdlog/spdlog.h"     // for set_level
+
+/**
+ *  Compare the throwing AlcPacket parser against AlcPacketView.
+ *
+ *  Usage: alc-parse-bench [iterations]
+ */
+auto main(int argc, char **argv) -> int {
+  uint64_t iterations = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 10'000'000;
+  spdlog::set_level(spdlog::level::off);
+
+  std::vector<char> content(1400, 'x');
+  LibFlute::FecOti fec_oti{LibFlute::FecScheme::CompactNoCode, 100'000, 1400, 64, {}};
+  std::vector<LibFlute::EncodingSymbol> symbols;
+  symbols.emplace_back(0, 0, content.data(), content.size(), LibFlute::FecScheme::CompactNoCode);
+
+  LibFlute::AlcPacket data_packet(16, 1, fec_oti, symbols, 1428, 0);
+  LibFlute::AlcPacket fdt_packet(16, 0, fec_oti, symbols, 1428, 1);
+  LibFlute::AlcPacket foreign_packet(17, 1, fec_oti, symbols, 1428, 0);
+  std::vector<char> malformed(data_packet.data(), data_packet.data() + data_packet.size());
+  malformed[0] = 0x20; // LCT version 2
+
+  printf("%zu iterations per benchmark\n", (size_t)iterations);
+
+  LibFlute::Bench::run("AlcPacket: data packet", iterations, [&]() {
+      LibFlute::AlcPacket alc(data_packet.data(), data_packet.size());
+      LibFlute::Bench::do_not_optimize(alc.toi());
+      });
+  LibFlute::Bench::run("AlcPacketView: data packet", iterations, [&]() {
+      LibFlute::AlcPacketView alc;
+      auto status = alc.parse(data_packet.data(), data_packet.size());
+      LibFlute::Bench::do_not_optimize(status);
+      LibFlute::Bench::do_not_optimize(alc.toi());
+      });
+
+  LibFlute::Bench::run("AlcPacket: FDT packet", iterations, [&]() {
+      LibFlute::AlcPacket alc(fdt_packet.data(), fdt_packet.size());
+      LibFlute::Bench::do_not_optimize(alc.fdt_instance_id());
+      });
+  LibFlute::Bench::run("AlcPacketView: FDT packet", iterations, [&]() {
+      LibFlute::AlcPacketView alc;
+      auto status = alc.parse(fdt_packet.data(), fdt_packet.size());
+      LibFlute::Bench::do_not_optimize(status);
+      LibFlute::Bench::do_not_optimize(alc.fdt_instance_id());
+      });
+  LibFlute::Bench::run("AlcPacketView: FDT packet incl. FEC OTI", iterations, [&]() {
+      LibFlute::AlcPacketView alc;
+      auto status = alc.parse(fdt_packet.data(), fdt_packet.size());
+      LibFlute::Bench::do_not_optimize(status);
+      LibFlute::Bench::do_not_optimize(alc.fec_oti().transfer_length);
+      });
+
+  LibFlute::Bench::run("AlcPacket: foreign TSI rejection", iterations, [&]() {
+      LibFlute::AlcPacket alc(foreign_packet.data(), foreign_packet.size());
+      LibFlute::Bench::do_not_optimize(alc.tsi() != 16);
+      });
+  LibFlute::Bench::run("AlcPacketView: foreign TSI rejection", iterations, [&]() {
+      uint64_t tsi = 0;
+      auto status = LibFlute::AlcPacketView::peek_tsi(foreign_packet.data(), foreign_packet.size(), tsi);
+      LibFlute::Bench::do_not_optimize(status);
+      LibFlute::Bench::do_not_optimize(tsi != 16);
+      });
+
+  LibFlute::Bench::run("AlcPacket: malformed packet", iterations / 10, [&]() {
+      try {
+        LibFlute::AlcPacket alc(malformed.data(), malformed.size());
+        LibFlute::Bench::do_not_optimize(alc.toi());
+      } catch (const char* ex) {
+        LibFlute::Bench::do_not_optimize(ex);
+      }
+      });
+  LibFlute::Bench::run("AlcPacketView: malformed packet", iterations, [&]() {
+      LibFlute::AlcPacketView alc;
+      auto status = alc.parse(malformed.data(), malformed.size());
+      LibFlute::Bench::do_not_optimize(status);
+      });
+
+  return 0;
+}
@@ -0,0 +1,132 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <argp.h>      // for argp, argp_option, argp_parser_t, argp_parse
+#include <chrono>      // for steady_clock, duration
+#include <cstdint>     // for uint64_t
+#include <cstdio>      // for printf
+#include <cstdlib>     // for strtod, strtol
+#include <fstream>     // for ifstream, ofstream
+#include <sstream>     // for stringstream
+#include <string>      // for string, getline
+#include <vector>      // for vector
+
+namespace LibFlute::Bench {
+  /**
+   *  Prevent the compiler from optimizing away a value computed in a benchmark loop
+   */
+  template <typename T>
+  inline void do_not_optimize(T const& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+  }
+
+  /**
+   *  Print the average time per operation
+   *
+   *  @return average nanoseconds per operation
+   */
+  inline double report(const std::string& name, uint64_t ops, std::chrono::duration<double, std::nano> elapsed) {
+    auto ns_per_op = elapsed.count() / static_cast<double>(ops > 0 ? ops : 1);
+    printf("%-48s %12.1f ns/op %14.0f ops/s\n", name.c_str(), ns_per_op, 1e9 / ns_per_op);
+    return ns_per_op;
+  }
+
+  /**
+   *  Run fn for the given number of iterations, and print the average time per iteration.
+   *
+   *  @return average nanoseconds per iteration
+   */
+  template <typename Fn>
+  inline double run(const std::string& name, uint64_t iterations, Fn&& fn) {
+    // warm up caches and branch predictors
+    for (uint64_t i = 0; i < iterations / 10; i++) {
+      fn();
+    }
+    auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+      fn();
+    }
+    return report(name, iterations, std::chrono::steady_clock::now() - start);
+  }
+
+  /**
+   *  Run fn once, for benchmarks that can not be repeated on the same state (e.g. one pass over
+   *  all symbols of an object), and print the average time per operation.
+   *
+   *  @param ops Number of operations fn performs
+   *  @return average nanoseconds per operation
+   */
+  template <typename Fn>
+  inline double run_once(const std::string& name, uint64_t ops, Fn&& fn) {
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return report(name, ops, std::chrono::steady_clock::now() - start);
+  }
+
+  /**
+   *  Parse the command line with argp. parse_opt receives a pointer to arguments in state->input.
+   */
+  template <typename Arguments>
+  inline void parse_arguments(int argc, char** argv, const argp_option* options, argp_parser_t parse_opt,
+      const char* doc, Arguments& arguments) {
+    struct argp argp = {options, parse_opt, nullptr, doc, nullptr, nullptr, nullptr};
+    argp_parse(&argp, argc, argv, 0, nullptr, &arguments);
+  }
+
+  /**
+   *  Parse a comma separated list of numbers, e.g. "1500,9000"
+   */
+  template <typename T>
+  inline std::vector<T> parse_list(const char* arg) {
+    std::vector<T> values;
+    std::stringstream ss(arg);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+      values.push_back(static_cast<T>(strtod(item.c_str(), nullptr)));
+    }
+    return values;
+  }
+
+  /**
+   *  Reset the peak resident set size of the process (VmHWM) to the current RSS, so that the
+   *  peak of one run can be measured on its own. Requires Linux 4.0 or later.
+   *
+   *  @return false if the peak could not be reset
+   */
+  inline bool reset_peak_rss() {
+    std::ofstream clear_refs("/proc/self/clear_refs");
+    clear_refs << "5";
+    clear_refs.flush();
+    return clear_refs.good();
+  }
+
+  /**
+   *  Peak resident set size since the start of the process or the last ::reset_peak_rss
+   *
+   *  @return peak RSS in kB, -1 if it could not be read
+   */
+  inline long peak_rss_kb() {
+    std::ifstream status("/proc/self/status");
+    std::string line;
+    while (std::getline(status, line)) {
+      if (line.rfind("VmHWM:", 0) == 0) {
+        return strtol(line.c_str() + 6, nullptr, 10);
+      }
+    }
+    return -1;
+  }
+};
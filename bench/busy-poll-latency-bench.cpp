@@ -0,0 +1,102 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include <boost/asio.hpp>      // for io_service
+#include <chrono>              // for steady_clock
+#include <cstdio>              // for printf
+#include <cstdlib>             // for strtoul
+#include <thread>              // for thread
+#include <vector>              // for vector
+#include "AlcPacket.h"         // for AlcPacket
+#include "File.h"              // for File
+#include "Receiver.h"          // for Receiver
+#include "flute_types.h"       // for FecOti, FecScheme
+#include "spdlog/spdlog.h"     // for set_level
+
+/**
+ *  Measure the latency from kernel reception to the end of packet handling in busy poll mode.
+ *
+ *  ALC packets of objects with in-band FEC OTI are sent over loopback at a fixed interval, so the
+ *  receiver is idle (spinning) when each packet arrives, and every packet is decoded into its object.
+ *
+ *  Usage: busy-poll-latency-bench [CPU to pin the polling thread to, -1 = none] [packets] [interval in us]
+ */
+auto main(int argc, char **argv) -> int {
+  int cpu = (argc > 1) ? atoi(argv[1]) : -1;
+  unsigned nof_packets = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 100000;
+  unsigned interval_us = (argc > 3) ? strtoul(argv[3], nullptr, 10) : 20;
+  spdlog::set_level(spdlog::level::warn);
+
+  const uint64_t tsi = 16;
+  const unsigned short port = 40500;
+  const char* group = "238.1.1.96";
+  const uint32_t max_payload = 1428;
+
+  // one object, sent repeatedly with a new TOI
+  std::vector<char> content(1024 * max_payload, 'x');
+  LibFlute::FecOti fec_oti{LibFlute::FecScheme::CompactNoCode, 0, max_payload, 64, {}};
+  std::vector<std::vector<char>> packets;
+  {
+    LibFlute::File file(1, fec_oti, "bench", "application/octet-stream", 0, content.data(), content.size());
+    for (;;) {
+      auto symbols = file.get_next_symbols(max_payload);
+      if (symbols.empty()) {
+        break;
+      }
+      LibFlute::AlcPacket packet(tsi, 1, file.meta().fec_oti, symbols, max_payload, 0, true);
+      packets.emplace_back(packet.data(), packet.data() + packet.size());
+      file.mark_completed(symbols, true);
+    }
+  }
+
+  boost::asio::io_service io;
+  LibFlute::Receiver receiver("0.0.0.0", group, port, tsi, io);
+  receiver.register_completion_callback([&](std::shared_ptr<LibFlute::File> /*file*/) {});
+  if (!receiver.enable_busy_poll(cpu)) {
+    printf("kernel busy polling not available, spinning in user space only\n");
+  }
+  std::thread io_thread([&]() { io.run(); });
+
+  boost::asio::io_service send_io;
+  boost::asio::ip::udp::socket sender(send_io, boost::asio::ip::udp::v4());
+  sender.set_option(boost::asio::ip::multicast::enable_loopback(true));
+  boost::asio::ip::udp::endpoint endpoint(boost::asio::ip::address::from_string(group), port);
+
+  auto next = std::chrono::steady_clock::now();
+  uint16_t toi = 1;
+  for (unsigned i = 0; i < nof_packets; i++) {
+    auto& packet = packets[i % packets.size()];
+    if (i % packets.size() == 0) {
+      toi = static_cast<uint16_t>(toi + 1);
+    }
+    packet[10] = (char)(toi >> 8); // TOI is the second half word after CCI
+    packet[11] = (char)(toi & 0xFF);
+
+    // sleep rather than spin, so the sender does not compete with the polling thread for a CPU
+    next += std::chrono::microseconds(interval_us);
+    std::this_thread::sleep_until(next);
+    sender.send_to(boost::asio::buffer(packet.data(), packet.size()), endpoint);
+  }
+  std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+  receiver.stop();
+  io_thread.join();
+
+  auto stats = receiver.latency_statistics();
+  printf("packets: %lu sent, %lu received\n", (unsigned long)nof_packets, (unsigned long)stats.count);
+  printf("latency: p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+      stats.p50_ns / 1e3, stats.p99_ns / 1e3, stats.p999_ns / 1e3, stats.max_ns / 1e3);
+  return 0;
+}
@@ -0,0 +1,144 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include <argp.h>                  // for argp_option, argp_state
+#include <algorithm>               // for min, max
+#include <boost/asio.hpp>          // for io_service
+#include <chrono>                  // for steady_clock, seconds
+#include <cstdio>                  // for printf
+#include <cstdlib>                 // for strtoul, strtod
+#include <memory>                  // for make_shared
+#include <string>                  // for string, to_string
+#include <vector>                  // for vector
+#include "ChannelReceiver.h"       // for ChannelReceiver
+#include "File.h"                  // for File
+#include "MemoryChannel.h"         // for MemoryChannel
+#include "Transmitter.h"           // for Transmitter
+#include "VirtualClock.h"          // for VirtualClock
+#include "bench_utils.h"           // for parse_arguments
+#include "flute_types.h"           // for FecScheme
+#include "spdlog/spdlog.h"         // for set_level
+
+static char doc[] = "Simulated-time carousel benchmark. Runs Transmitter -> MemoryChannel -> ChannelReceiver " //NOLINT
+  "on a VirtualClock, sending one object over and over at the given rate for the given (simulated) duration, "
+  "while the receiver expires old files once per minute.";
+
+static struct argp_option options[] = {  // NOLINT
+    {"duration", 'd', "SECONDS", 0, "Simulated duration (default: 3600)", 0},
+    {"rate", 'r', "KBPS", 0, "Transmit rate limit (default: 1000)", 0},
+    {"size", 's', "BYTES", 0, "Object size (default: 100000)", 0},
+    {"loss", 'l', "P", 0, "Bernoulli packet loss probability (default: 0.01)", 0},
+    {"delay", 'y', "MS", 0, "Channel delay (default: 20)", 0},
+    {"max-age", 'a', "SECONDS", 0, "Age after which the receiver removes files (default: 60)", 0},
+    {nullptr, 0, nullptr, 0, nullptr, 0}};
+
+struct bench_arguments {
+  unsigned duration = 3600;
+  unsigned rate = 1000;
+  size_t size = 100000;
+  double loss = 0.01;
+  unsigned delay_ms = 20;
+  unsigned max_age = 60;
+};
+
+static auto parse_opt(int key, char *arg, struct argp_state *state) -> error_t {
+  auto arguments = static_cast<struct bench_arguments *>(state->input);
+  switch (key) {
+    case 'd':
+      arguments->duration = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    case 'r':
+      arguments->rate = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    case 's':
+      arguments->size = strtoul(arg, nullptr, 10);
+      break;
+    case 'l':
+      arguments->loss = strtod(arg, nullptr);
+      break;
+    case 'y':
+      arguments->delay_ms = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    case 'a':
+      arguments->max_age = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+  }
+  return 0;
+}
+
+/**
+ *  Usage: carousel-sim-bench [OPTION...], see --help
+ */
+auto main(int argc, char **argv) -> int {
+  struct bench_arguments arguments;
+  LibFlute::Bench::parse_arguments(argc, argv, options, parse_opt, doc, arguments);
+  spdlog::set_level(spdlog::level::off);
+
+  const std::string address = "238.1.1.95";
+  const unsigned short port = 40085;
+  const uint64_t tsi = 16;
+  std::vector<char> content(arguments.size, 'x');
+
+  boost::asio::io_service io;
+  auto clock = std::make_shared<LibFlute::VirtualClock>();
+  LibFlute::MemoryChannel::Impairments impairments;
+  impairments.loss = arguments.loss;
+  impairments.delay_us = arguments.delay_ms * 1000;
+  auto channel = std::make_shared<LibFlute::MemoryChannel>(io, impairments, clock);
+  LibFlute::ChannelReceiver receiver(channel, address, port, tsi);
+  LibFlute::Transmitter transmitter(address, static_cast<short>(port), tsi, 1500, arguments.rate,
+      LibFlute::FecScheme::CompactNoCode, io, clock);
+  transmitter.set_transport(channel);
+
+  uint64_t sent = 0;
+  uint64_t received = 0;
+  auto send_next = [&]() {
+    transmitter.send("carousel" + std::to_string(sent), "application/octet-stream",
+        clock->seconds_since_epoch() + arguments.max_age, content.data(), content.size());
+    sent++;
+  };
+  transmitter.register_completion_callback([&](uint32_t /*toi*/) { send_next(); });
+  receiver.register_completion_callback([&](std::shared_ptr<LibFlute::File> /*file*/) { received++; });
+
+  auto start = std::chrono::steady_clock::now();
+  send_next();
+  size_t expiries = 0;
+  size_t max_files = 0;
+  for (unsigned minute = 0; minute * 60 < arguments.duration; minute++) {
+    expiries += clock->run_for(io, std::chrono::seconds(std::min(60U, arguments.duration - minute * 60)));
+    max_files = std::max(max_files, receiver.file_list().size());
+    receiver.remove_expired_files(arguments.max_age);
+  }
+  std::chrono::duration<double> wall = std::chrono::steady_clock::now() - start;
+
+  auto stats = channel->statistics();
+  printf("simulated %u s in %.3f s wall clock (%.0fx), %zu timer expiries\n",
+      arguments.duration, wall.count(), arguments.duration / wall.count(), expiries);
+  printf("objects sent %lu, received %lu (%.1f%%), max. %zu incomplete files held by the receiver\n",
+      sent, received, sent > 0 ? 100.0 * received / sent : 0.0, max_files);
+  printf("packets sent %lu, delivered %lu, lost %lu\n", stats.sent, stats.delivered, stats.lost);
+
+  auto tx = transmitter.metrics();
+  printf("transmitter: %lu packets, %lu bytes, %lu files queued, %lu packets in flight, "
+      "pacing lag p50 %lu ns p99 %lu ns max %lu ns\n", tx.packets, tx.bytes, tx.files_queued,
+      tx.packets_in_flight, tx.pacing_lag.p50_ns, tx.pacing_lag.p99_ns, tx.pacing_lag.max_ns);
+  auto rx = receiver.metrics();
+  printf("receiver: %lu packets, %lu bytes, %lu duplicate symbols, %lu FDT instances, %lu completed, "
+      "%lu expired, %lu bytes buffered\n", rx.packets, rx.bytes, rx.duplicate_symbols, rx.fdt_instances,
+      rx.completed_objects, rx.expired_objects, rx.bytes_buffered);
+  return 0;
+}
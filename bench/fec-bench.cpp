@@ -0,0 +1,298 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include <argp.h>                  // for argp_option, argp_state
+#include <time.h>                  // for clock_gettime, CLOCK_THREAD_CPUTIME_ID
+#include <algorithm>               // for sort, min
+#include <chrono>                  // for steady_clock
+#include <cstdio>                  // for printf
+#include <cstdlib>                 // for strtoul, strtod
+#include <cstring>                 // for memcmp
+#include <map>                     // for map
+#include <random>                  // for mt19937_64, uniform_real_distribution
+#include <string>                  // for string
+#include <vector>                  // for vector
+#include "bench_utils.h"           // for run, parse_arguments, parse_list, reset_peak_rss, peak_rss_kb
+#include "fec/RaptorFEC.h"         // for RaptorFEC
+#include "flute_types.h"           // for FecOti, SourceBlock, Symbol
+#include "raptor.h"                // for create_encoder_context, create_decoder_context
+#include "spdlog/spdlog.h"         // for set_level
+
+static char doc[] = "Benchmark and efficiency harness for the Raptor FEC codec: encode and decode throughput, " //NOLINT
+  "codec setup cost per K, peak memory, and the reception overhead (symbols needed beyond K) under packet loss.";
+
+static struct argp_option options[] = {  // NOLINT
+    {"sizes", 's', "BYTES,...", 0, "Object sizes for the throughput runs (default: 1048576,16777216)", 0},
+    {"payloads", 'p', "BYTES,...", 0, "Max. payload sizes to derive the symbol size from (default: 1428,8936)", 0},
+    {"loss", 'l', "P,...", 0, "Packet loss rates for the overhead runs (default: 0,0.01,0.05,0.1,0.2)", 0},
+    {"bursts", 'b', "N,...", 0, "Mean loss burst lengths, 1 = independent losses (default: 1,10)", 0},
+    {"trials", 'n', "N", 0, "Trials per loss pattern (default: 50)", 0},
+    {"ratio", 'r', "RATIO", 0, "Encoding symbols generated per source symbol for the overhead runs (default: 2.0)", 0},
+    {nullptr, 0, nullptr, 0, nullptr, 0}};
+
+struct bench_arguments {
+  std::vector<size_t> sizes = {1048576, 16777216};
+  std::vector<unsigned> payloads = {1428, 8936};
+  std::vector<double> loss_rates = {0, 0.01, 0.05, 0.1, 0.2};
+  std::vector<double> bursts = {1, 10};
+  unsigned trials = 50;
+  double ratio = 2.0;
+};
+
+static auto parse_opt(int key, char *arg, struct argp_state *state) -> error_t {
+  using LibFlute::Bench::parse_list;
+  auto arguments = static_cast<struct bench_arguments *>(state->input);
+  switch (key) {
+    case 's':
+      arguments->sizes = parse_list<size_t>(arg);
+      break;
+    case 'p':
+      arguments->payloads = parse_list<unsigned>(arg);
+      break;
+    case 'l':
+      arguments->loss_rates = parse_list<double>(arg);
+      break;
+    case 'b':
+      arguments->bursts = parse_list<double>(arg);
+      break;
+    case 'n':
+      arguments->trials = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    case 'r':
+      arguments->ratio = strtod(arg, nullptr);
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+  }
+  return 0;
+}
+
+namespace {
+  auto thread_cpu_seconds() -> double {
+    struct timespec ts = {};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<double>(ts.tv_sec) + static_cast<double>(ts.tv_nsec) / 1e9;
+  }
+
+  void free_blocks(std::map<uint16_t, LibFlute::SourceBlock>& blocks) {
+    for (auto& block : blocks) {
+      for (auto& symbol : block.second.symbols) {
+        delete[] symbol.second.data;
+      }
+    }
+    blocks.clear();
+  }
+
+  auto decoder_for(const LibFlute::RaptorFEC& encoder, size_t object_size) -> LibFlute::FecOti {
+    return LibFlute::FecOti{LibFlute::FecScheme::Raptor, object_size, encoder.T, encoder.K * encoder.T,
+      encoder.scheme_specific_info()};
+  }
+
+  auto source_symbols(const LibFlute::RaptorFEC& encoder, uint16_t sbn) -> unsigned {
+    return sbn < encoder.Z - 1 ? encoder.K : encoder.Kt - encoder.K * (encoder.Z - 1);
+  }
+
+  /**
+   *  Feed the encoding symbols of one source block to the decoder until it has finished. Like File
+   *  does, the target block holds a buffer for each source symbol, that the decoded data is extracted to.
+   *
+   *  @return number of symbols processed, or 0 if the block could not be decoded
+   */
+  auto decode_block(LibFlute::RaptorFEC& decoder, const LibFlute::SourceBlock& block, LibFlute::SourceBlock& target,
+      const std::vector<bool>* lost = nullptr) -> unsigned {
+    target.id = block.id;
+    for (unsigned i = 0; i < source_symbols(decoder, block.id); i++) {
+      target.symbols[i] = LibFlute::Symbol{new char[decoder.T], decoder.T};
+    }
+    unsigned received = 0;
+    for (const auto& symbol : block.symbols) {
+      if (lost != nullptr && (*lost)[symbol.first]) {
+        continue;
+      }
+      auto copy = symbol.second;
+      decoder.process_symbol(target, copy, symbol.first);
+      received++;
+      if (decoder.check_source_block_completion(target)) {
+        return received;
+      }
+    }
+    return 0;
+  }
+
+  /**
+   *  Encode and decode whole objects without loss
+   */
+  void throughput(size_t object_size, unsigned max_payload) {
+    LibFlute::Bench::reset_peak_rss();
+    std::vector<char> content(object_size);
+    std::mt19937_64 random(object_size);
+    for (auto& byte : content) {
+      byte = static_cast<char>(random());
+    }
+
+    LibFlute::RaptorFEC encoder(object_size, max_payload);
+    int bytes_read = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto cpu_start = thread_cpu_seconds();
+    auto blocks = encoder.create_blocks(content.data(), &bytes_read);
+    std::chrono::duration<double> encode_wall = std::chrono::steady_clock::now() - start;
+    auto encode_cpu = thread_cpu_seconds() - cpu_start;
+
+    LibFlute::RaptorFEC decoder;
+    decoder.parse_fec_oti(decoder_for(encoder, object_size));
+    start = std::chrono::steady_clock::now();
+    cpu_start = thread_cpu_seconds();
+    bool decoded = true;
+    std::map<uint16_t, LibFlute::SourceBlock> targets;
+    for (const auto& block : blocks) {
+      decoded = decode_block(decoder, block.second, targets[block.first]) > 0 && decoded;
+    }
+    decoder.extract_file(targets);
+    std::chrono::duration<double> decode_wall = std::chrono::steady_clock::now() - start;
+    auto decode_cpu = thread_cpu_seconds() - cpu_start;
+
+    // the decoded source symbols must match the object
+    for (const auto& target : targets) {
+      size_t offset = static_cast<size_t>(target.first) * encoder.K * encoder.T;
+      for (const auto& symbol : target.second.symbols) {
+        auto pos = offset + static_cast<size_t>(symbol.first) * encoder.T;
+        if (pos < object_size) {
+          auto len = std::min<size_t>(encoder.T, object_size - pos);
+          decoded = decoded && memcmp(symbol.second.data, content.data() + pos, len) == 0;
+        }
+      }
+    }
+    free_blocks(targets);
+
+    auto mb = static_cast<double>(object_size) / 1e6;
+    printf("%10zu B, payload %5u: Z %u, K %5u, T %5u | encode %8.1f MB/s (%8.1f MB/s per core) | "
+        "decode %8.1f MB/s (%8.1f MB/s per core) %s | peak RSS %ld kB\n",
+        object_size, max_payload, encoder.Z, encoder.K, encoder.T,
+        mb / encode_wall.count(), mb / encode_cpu, mb / decode_wall.count(), mb / decode_cpu,
+        decoded ? "ok" : "FAILED", LibFlute::Bench::peak_rss_kb());
+    free_blocks(blocks);
+  }
+
+  /**
+   *  Cost of creating the encoder and decoder contexts for one source block
+   */
+  void setup_cost(unsigned k, unsigned symbol_size) {
+    std::vector<unsigned char> block(static_cast<size_t>(k) * symbol_size, 'x');
+    auto iterations = std::max<uint64_t>(8192 / k, 2);
+    auto encoder_ns = LibFlute::Bench::run("encoder setup, K " + std::to_string(k), iterations, [&]() {
+        auto* sc = create_encoder_context(block.data(), k, symbol_size, k * symbol_size, 0);
+        free_encoder_context(sc);
+        });
+    auto decoder_ns = LibFlute::Bench::run("decoder setup, K " + std::to_string(k), iterations, [&]() {
+        auto* sc = create_encoder_context(nullptr, k, symbol_size, k * symbol_size, 0);
+        auto* dc = create_decoder_context(sc);
+        free_decoder_context(dc);
+        });
+    printf("%-48s %12.1f ns/K (encoder) %9.1f ns/K (decoder)\n", "", encoder_ns / k, decoder_ns / k);
+  }
+
+  /**
+   *  Symbols needed beyond K to decode the first source block, when the encoding symbols are
+   *  sent in order and lost according to a Gilbert-Elliott model with the given mean loss rate and
+   *  mean burst length (independent losses for a burst length of 1).
+   */
+  void reception_overhead(size_t object_size, unsigned max_payload, double ratio,
+      double loss, double burst, unsigned trials) {
+    std::vector<char> content(object_size, 'x');
+    LibFlute::RaptorFEC encoder(object_size, max_payload);
+    encoder.set_surplus_packet_ratio(static_cast<float>(ratio));
+    int bytes_read = 0;
+    auto blocks = encoder.create_blocks(content.data(), &bytes_read);
+    const auto& block = blocks.begin()->second;
+    unsigned k = source_symbols(encoder, block.id);
+
+    double p_bad_good = burst > 1 ? 1.0 / burst : 1.0;
+    double p_good_bad = loss < 1 ? loss * p_bad_good / (1 - loss) : 1.0;
+
+    std::vector<double> overheads;
+    std::vector<double> needed_ratios;
+    unsigned failures = 0;
+    for (unsigned trial = 0; trial < trials; trial++) {
+      std::mt19937_64 random(trial + 1);
+      std::uniform_real_distribution<double> uniform(0.0, 1.0);
+      std::vector<bool> lost(block.symbols.size());
+      bool bad = false;
+      for (size_t i = 0; i < lost.size(); i++) {
+        bad = bad ? uniform(random) >= p_bad_good : uniform(random) < p_good_bad;
+        lost[i] = burst > 1 ? bad : uniform(random) < loss;
+      }
+
+      LibFlute::RaptorFEC decoder;
+      decoder.parse_fec_oti(decoder_for(encoder, object_size));
+      std::map<uint16_t, LibFlute::SourceBlock> target;
+      auto received = decode_block(decoder, block, target[block.id], &lost);
+      free_blocks(target);
+      if (received == 0) {
+        failures++;
+        continue;
+      }
+      overheads.push_back(static_cast<double>(received) - k);
+
+      // encoding symbols the sender had to generate for this receiver
+      unsigned sent = 0;
+      for (unsigned seen = 0; seen < received; sent++) {
+        seen += lost[sent] ? 0 : 1;
+      }
+      needed_ratios.push_back(static_cast<double>(sent) / k);
+    }
+    free_blocks(blocks);
+
+    std::sort(overheads.begin(), overheads.end());
+    std::sort(needed_ratios.begin(), needed_ratios.end());
+    auto at = [](const std::vector<double>& v, double p) {
+      return v.empty() ? 0.0 : v[static_cast<size_t>(p * static_cast<double>(v.size() - 1) + 0.5)];
+    };
+    printf("K %5u, T %5u, loss %5.3f, burst %5.1f | overhead symbols p50 %6.1f p99 %6.1f max %6.1f | "
+        "surplus ratio needed p50 %5.3f p99 %5.3f max %5.3f | %u/%u not decodable with ratio %.2f\n",
+        k, encoder.T, loss, burst, at(overheads, 0.5), at(overheads, 0.99), at(overheads, 1.0),
+        at(needed_ratios, 0.5), at(needed_ratios, 0.99), at(needed_ratios, 1.0), failures, trials, ratio);
+  }
+} // namespace
+
+/**
+ *  Usage: fec-bench [OPTION...], see --help
+ */
+auto main(int argc, char **argv) -> int {
+  struct bench_arguments arguments;
+  LibFlute::Bench::parse_arguments(argc, argv, options, parse_opt, doc, arguments);
+  spdlog::set_level(spdlog::level::off);
+
+  printf("Throughput\n");
+  for (auto size : arguments.sizes) {
+    for (auto payload : arguments.payloads) {
+      throughput(size, payload);
+    }
+  }
+
+  printf("\nSetup cost\n");
+  for (unsigned k : {64, 256, 1024, 4096, 8192}) {
+    setup_cost(k, 1428);
+  }
+
+  printf("\nReception overhead (first source block of a %zu B object)\n", arguments.sizes.front());
+  for (auto payload : arguments.payloads) {
+    for (auto burst : arguments.bursts) {
+      for (auto loss : arguments.loss_rates) {
+        reception_overhead(arguments.sizes.front(), payload, arguments.ratio, loss, burst, arguments.trials);
+      }
+    }
+  }
+  return 0;
+}
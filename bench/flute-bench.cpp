@@ -0,0 +1,241 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include <argp.h>                  // for argp_option, argp_state
+#include <sys/resource.h>          // for getrusage, rusage
+#include <algorithm>               // for sort
+#include <boost/asio.hpp>          // for io_service
+#include <chrono>                  // for steady_clock
+#include <cstdio>                  // for printf
+#include <cstdlib>                 // for strtoul, strtod
+#include <map>                     // for map
+#include <memory>                  // for make_shared
+#include <string>                  // for string, to_string
+#include <vector>                  // for vector
+#include "ChannelReceiver.h"       // for ChannelReceiver
+#include "File.h"                  // for File
+#include "MemoryChannel.h"         // for MemoryChannel
+#include "Transmitter.h"           // for Transmitter
+#include "Version.h"               // for VERSION_MAJOR, VERSION_MINOR
+#include "bench_utils.h"           // for parse_arguments, parse_list, reset_peak_rss, peak_rss_kb
+#include "flute_types.h"           // for FecScheme
+#include "spdlog/spdlog.h"         // for set_level
+
+static char doc[] = "End-to-end FLUTE throughput benchmark. Runs Transmitter -> MemoryChannel -> ChannelReceiver " //NOLINT
+  "in one process for every combination of the given object sizes, MTUs, FEC schemes and loss rates, "
+  "and prints the results as JSON.";
+
+static struct argp_option options[] = {  // NOLINT
+    {"sizes", 's', "BYTES,...", 0, "Object sizes (default: 65536,1048576,16777216)", 0},
+    {"mtus", 'm', "BYTES,...", 0, "MTUs (default: 1500,9000)", 0},
+    {"fec", 'f', "SCHEME,...", 0, "FEC schemes, Compact No Code = 0, Raptor = 1 (default: 0,1)", 0},
+    {"loss", 'l', "P,...", 0, "Bernoulli packet loss probabilities (default: 0,0.01,0.05)", 0},
+    {"objects", 'n', "N", 0, "Objects to transfer per run (default: 8)", 0},
+    {"timeout", 't', "SECONDS", 0, "Maximum duration of a run (default: 30)", 0},
+    {nullptr, 0, nullptr, 0, nullptr, 0}};
+
+struct bench_arguments {
+  std::vector<size_t> sizes = {65536, 1048576, 16777216};
+  std::vector<unsigned> mtus = {1500, 9000};
+  std::vector<unsigned> fec_schemes = {0, 1};
+  std::vector<double> loss_rates = {0, 0.01, 0.05};
+  unsigned nof_objects = 8;
+  double timeout = 30;
+};
+
+static auto parse_opt(int key, char *arg, struct argp_state *state) -> error_t {
+  using LibFlute::Bench::parse_list;
+  auto arguments = static_cast<struct bench_arguments *>(state->input);
+  switch (key) {
+    case 's':
+      arguments->sizes = parse_list<size_t>(arg);
+      break;
+    case 'm':
+      arguments->mtus = parse_list<unsigned>(arg);
+      break;
+    case 'f':
+      arguments->fec_schemes = parse_list<unsigned>(arg);
+      break;
+    case 'l':
+      arguments->loss_rates = parse_list<double>(arg);
+      break;
+    case 'n':
+      arguments->nof_objects = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    case 't':
+      arguments->timeout = strtod(arg, nullptr);
+      break;
+    default:
+      return ARGP_ERR_UNKNOWN;
+  }
+  return 0;
+}
+
+/**
+ *  Results of one benchmark run
+ */
+struct RunResult {
+  bool supported = true;
+  unsigned objects_sent = 0;
+  unsigned objects_received = 0;
+  uint64_t bytes_received = 0;
+  double seconds = 0;
+  LibFlute::MemoryChannel::Statistics channel = {};
+  double cpu_seconds = 0;
+  long peak_rss_kb = -1;            /**< -1 if the peak could not be reset for the run */
+  std::vector<double> latencies_ms;
+};
+
+static auto cpu_seconds() -> double {
+  struct rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+    static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+/**
+ *  Transfer nof_objects objects one after another, each one queued when the transmitter has
+ *  finished sending the previous one. The completion latency of an object is the time from
+ *  queueing it to its delivery by the receiver.
+ */
+static auto run(size_t size, unsigned mtu, unsigned fec, double loss, unsigned nof_objects, double timeout) -> RunResult {
+  using clock = std::chrono::steady_clock;
+  const std::string address = "238.1.1.95";
+  const unsigned short port = 40085;
+  const uint64_t tsi = 16;
+
+  RunResult result;
+  std::vector<char> content(size, 'x');
+
+  boost::asio::io_service io;
+  LibFlute::MemoryChannel::Impairments impairments;
+  impairments.loss = loss;
+  auto channel = std::make_shared<LibFlute::MemoryChannel>(io, impairments);
+  LibFlute::ChannelReceiver receiver(channel, address, port, tsi);
+  LibFlute::Transmitter transmitter(address, static_cast<short>(port), tsi, static_cast<unsigned short>(mtu), 0,
+      LibFlute::FecScheme(fec), io);
+  transmitter.set_transport(channel);
+  transmitter.set_in_band_fti(true);
+
+  std::map<uint32_t, clock::time_point> queued;
+  auto last_event = clock::now();
+  auto send_next = [&]() {
+    auto toi = transmitter.send("bench" + std::to_string(result.objects_sent), "application/octet-stream",
+        transmitter.seconds_since_epoch() + 600, content.data(), content.size());
+    if (toi == 0xFFFF) {
+      result.supported = false;
+      return;
+    }
+    queued[toi] = clock::now();
+    result.objects_sent++;
+  };
+
+  receiver.register_completion_callback([&](std::shared_ptr<LibFlute::File> file) {
+      auto it = queued.find(file->meta().toi);
+      if (it == queued.end()) {
+        return;
+      }
+      last_event = clock::now();
+      std::chrono::duration<double, std::milli> latency = last_event - it->second;
+      result.latencies_ms.push_back(latency.count());
+      result.objects_received++;
+      result.bytes_received += file->meta().content_length;
+  });
+  bool transmitted = false;
+  transmitter.register_completion_callback([&](uint32_t /*toi*/) {
+      last_event = clock::now();
+      if (result.objects_sent < nof_objects) {
+        send_next();
+      } else {
+        transmitted = true;
+      }
+  });
+
+  bool peak_rss_reset = LibFlute::Bench::reset_peak_rss();
+  auto cpu_start = cpu_seconds();
+  auto start = clock::now();
+  send_next();
+  auto deadline = start + std::chrono::duration<double>(timeout);
+
+  // objects that are not complete when the transmitter is done have been lost, but give the
+  // channel a moment to deliver what is still in flight
+  while (result.supported && result.objects_received < nof_objects && clock::now() < deadline &&
+      !(transmitted && clock::now() - last_event > std::chrono::milliseconds(200))) {
+    io.run_for(std::chrono::milliseconds(10));
+  }
+
+  std::chrono::duration<double> elapsed = last_event - start;
+  result.seconds = elapsed.count();
+  result.cpu_seconds = cpu_seconds() - cpu_start;
+  result.channel = channel->statistics();
+  if (peak_rss_reset) {
+    result.peak_rss_kb = LibFlute::Bench::peak_rss_kb();
+  }
+  return result;
+}
+
+static auto percentile(std::vector<double> values, double p) -> double {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  auto index = static_cast<size_t>(p * static_cast<double>(values.size() - 1) + 0.5);
+  return values[index];
+}
+
+/**
+ *  Print the results of all runs as a JSON document on stdout.
+ *
+ *  Usage: flute-bench [OPTION...], see --help
+ */
+auto main(int argc, char **argv) -> int {
+  struct bench_arguments arguments;
+  LibFlute::Bench::parse_arguments(argc, argv, options, parse_opt, doc, arguments);
+  spdlog::set_level(spdlog::level::off); // the default logger writes to stdout
+
+  printf("{\n  \"version\": \"%d.%d.%d\",\n  \"runs\": [", VERSION_MAJOR, VERSION_MINOR, VERSION_PATCH);
+  bool first = true;
+  for (auto size : arguments.sizes) {
+    for (auto mtu : arguments.mtus) {
+      for (auto fec : arguments.fec_schemes) {
+        for (auto loss : arguments.loss_rates) {
+          auto r = run(size, mtu, fec, loss, arguments.nof_objects, arguments.timeout);
+          auto seconds = r.seconds > 0 ? r.seconds : 1e-9;
+          printf("%s\n    {\"object_size\": %zu, \"mtu\": %u, \"fec\": %u, \"loss\": %g, \"supported\": %s",
+              first ? "" : ",", size, mtu, fec, loss, r.supported ? "true" : "false");
+          if (r.supported) {
+            printf(", \"objects_sent\": %u, \"objects_received\": %u, \"seconds\": %.6f"
+                ", \"goodput_mbps\": %.3f, \"packets_per_second\": %.0f"
+                ", \"packets_sent\": %lu, \"packets_lost\": %lu"
+                ", \"cpu_seconds_per_gb\": %.3f, \"peak_rss_kb\": %s"
+                ", \"latency_ms\": {\"p50\": %.3f, \"p99\": %.3f, \"max\": %.3f}",
+                r.objects_sent, r.objects_received, r.seconds,
+                static_cast<double>(r.bytes_received) * 8 / seconds / 1e6,
+                static_cast<double>(r.channel.sent) / seconds,
+                r.channel.sent, r.channel.lost,
+                r.bytes_received > 0 ? r.cpu_seconds / (static_cast<double>(r.bytes_received) / 1e9) : 0.0,
+                r.peak_rss_kb >= 0 ? std::to_string(r.peak_rss_kb).c_str() : "null",
+                percentile(r.latencies_ms, 0.5), percentile(r.latencies_ms, 0.99), percentile(r.latencies_ms, 1.0));
+          }
+          printf("}");
+          fflush(stdout);
+          first = false;
+        }
+      }
+    }
+  }
+  printf("\n  ]\n}\n");
+  return 0;
+}
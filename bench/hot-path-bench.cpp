@@ -0,0 +1,171 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include <algorithm>               // for max
+#include <chrono>                  // for steady_clock
+#include <cstdlib>                 // for strtoull
+#include <string>                  // for string, to_string
+#include <vector>                  // for vector
+#include "AlcPacket.h"             // for AlcPacket
+#include "AlcPacketView.h"         // for AlcPacketView
+#include "EncodingSymbol.h"        // for EncodingSymbol
+#include "File.h"                  // for File
+#include "FileDeliveryTable.h"     // for FileDeliveryTable
+#include "bench_utils.h"           // for run, run_once, report
+#include "flute_types.h"           // for FecOti, FecScheme
+#include "spdlog/spdlog.h"         // for set_level
+
+namespace {
+  const uint32_t max_payload = 1428;
+
+  /**
+   *  Transmit all symbols of an object, and decode them into a second one
+   */
+  void file_benchmarks(size_t object_size)
+  {
+    std::vector<char> content(object_size, 'x');
+    LibFlute::FecOti fec_oti{LibFlute::FecScheme::CompactNoCode, object_size, max_payload, 64, {}};
+    auto size = std::to_string(object_size) + " B";
+
+    // Transmit the object, timing each call. The symbols are kept for the receiving side.
+    std::vector<LibFlute::EncodingSymbol> symbols;
+    symbols.reserve(object_size / max_payload + 1);
+    {
+      LibFlute::File file(1, fec_oti, "bench", "application/octet-stream", 0, content.data(), content.size());
+      std::chrono::duration<double, std::nano> get_time{};
+      std::chrono::duration<double, std::nano> mark_time{};
+      uint64_t calls = 0;
+      for (;;) {
+        auto start = std::chrono::steady_clock::now();
+        auto next = file.get_next_symbols(max_payload);
+        auto got = std::chrono::steady_clock::now();
+        get_time += got - start;
+        if (next.empty()) {
+          break;
+        }
+        file.mark_completed(next, true);
+        mark_time += std::chrono::steady_clock::now() - got;
+        symbols.insert(symbols.end(), next.begin(), next.end());
+        calls++;
+      }
+      LibFlute::Bench::do_not_optimize(file.complete());
+      LibFlute::Bench::report("File::get_next_symbols, " + size, calls, get_time);
+      LibFlute::Bench::report("File::mark_completed, " + size, calls, mark_time);
+    }
+    {
+      LibFlute::FileDeliveryTable::FileEntry entry{1, "bench", static_cast<uint32_t>(object_size), "", "", 0, fec_oti, nullptr};
+      LibFlute::File file(entry);
+      LibFlute::Bench::run_once("File::put_symbol, " + size, symbols.size(), [&]() {
+          for (const auto& symbol : symbols) {
+            file.put_symbol(symbol);
+          }
+          });
+      LibFlute::Bench::do_not_optimize(file.complete());
+    }
+  }
+
+  void fdt_benchmarks(unsigned nof_entries)
+  {
+    LibFlute::FecOti fec_oti{LibFlute::FecScheme::CompactNoCode, 0, max_payload, 64, {}};
+    LibFlute::FileDeliveryTable fdt(1, fec_oti);
+    for (unsigned i = 0; i < nof_entries; i++) {
+      auto entry_oti = fec_oti;
+      entry_oti.transfer_length = 1'000'000;
+      LibFlute::FileDeliveryTable::FileEntry entry{i + 1, "http://localhost/file" + std::to_string(i), 1'000'000,
+        "LVsUEGljCHvO0rk4AuCZUw==", "application/octet-stream", 3'900'000'000, entry_oti, nullptr};
+      fdt.add(entry);
+    }
+    auto xml = fdt.to_string();
+
+    // keep the total work roughly constant across table sizes
+    uint64_t iterations = std::max<uint64_t>(100'000 / nof_entries, 2);
+    auto entries = std::to_string(nof_entries) + " entries";
+    LibFlute::Bench::run("FileDeliveryTable::to_string, " + entries, iterations, [&]() {
+        LibFlute::Bench::do_not_optimize(fdt.to_string().size());
+        });
+    LibFlute::Bench::run("FileDeliveryTable parse, " + entries, iterations, [&]() {
+        LibFlute::FileDeliveryTable parsed(1, xml.data(), xml.size());
+        LibFlute::Bench::do_not_optimize(parsed.instance_id());
+        });
+  }
+} // namespace
+
+/**
+ *  Micro benchmarks for the packet and symbol hot paths: building and parsing ALC packets, encoding
+ *  symbol (de)serialization, object transmission and reception, and the FDT.
+ *
+ *  Usage: hot-path-bench [iterations] [large object size in bytes]
+ *  The large object defaults to 256 MiB. Multi-GB sizes need about twice the object size in memory.
+ */
+auto main(int argc, char **argv) -> int {
+  uint64_t iterations = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 1'000'000;
+  size_t large_object_size = (argc > 2) ? strtoull(argv[2], nullptr, 10) : 256 * 1024 * 1024;
+  spdlog::set_level(spdlog::level::off);
+
+  std::vector<char> content(max_payload, 'x');
+  LibFlute::FecOti fec_oti{LibFlute::FecScheme::CompactNoCode, 100'000, max_payload, 64, {}};
+  std::vector<LibFlute::EncodingSymbol> symbols;
+  symbols.emplace_back(0, 0, content.data(), content.size(), LibFlute::FecScheme::CompactNoCode);
+
+  printf("%zu iterations per benchmark\n", (size_t)iterations);
+
+  LibFlute::Bench::run("AlcPacket: build data packet", iterations, [&]() {
+      LibFlute::AlcPacket alc(16, 1, fec_oti, symbols, max_payload, 0);
+      LibFlute::Bench::do_not_optimize(alc.size());
+      });
+  LibFlute::Bench::run("AlcPacket: build data packet with EXT_FTI", iterations, [&]() {
+      LibFlute::AlcPacket alc(16, 1, fec_oti, symbols, max_payload, 0, true);
+      LibFlute::Bench::do_not_optimize(alc.size());
+      });
+  LibFlute::Bench::run("AlcPacket: build FDT packet (EXT_FDT, EXT_FTI)", iterations, [&]() {
+      LibFlute::AlcPacket alc(16, 0, fec_oti, symbols, max_payload, 1);
+      LibFlute::Bench::do_not_optimize(alc.size());
+      });
+
+  LibFlute::AlcPacket data_packet(16, 1, fec_oti, symbols, max_payload, 0);
+  LibFlute::AlcPacket fdt_packet(16, 0, fec_oti, symbols, max_payload, 1);
+  LibFlute::Bench::run("AlcPacketView: parse data packet", iterations, [&]() {
+      LibFlute::AlcPacketView alc;
+      LibFlute::Bench::do_not_optimize(alc.parse(data_packet.data(), data_packet.size()));
+      LibFlute::Bench::do_not_optimize(alc.toi());
+      });
+  LibFlute::Bench::run("AlcPacketView: parse FDT packet", iterations, [&]() {
+      LibFlute::AlcPacketView alc;
+      LibFlute::Bench::do_not_optimize(alc.parse(fdt_packet.data(), fdt_packet.size()));
+      LibFlute::Bench::do_not_optimize(alc.fdt_instance_id());
+      });
+
+  LibFlute::AlcPacketView view;
+  view.parse(data_packet.data(), data_packet.size());
+  std::vector<LibFlute::EncodingSymbol> decoded;
+  LibFlute::Bench::run("EncodingSymbol::from_payload", iterations, [&]() {
+      LibFlute::EncodingSymbol::from_payload(data_packet.data() + view.header_length(), view.payload_length(),
+          fec_oti, LibFlute::ContentEncoding::NONE, decoded);
+      LibFlute::Bench::do_not_optimize(decoded.size());
+      });
+  std::vector<char> payload(max_payload + 4);
+  LibFlute::Bench::run("EncodingSymbol::to_payload", iterations, [&]() {
+      LibFlute::Bench::do_not_optimize(
+          LibFlute::EncodingSymbol::to_payload(symbols, payload.data(), payload.size(), fec_oti));
+      });
+
+  file_benchmarks(64 * 1024);
+  file_benchmarks(large_object_size);
+
+  for (unsigned nof_entries : {10, 100, 1000, 10'000, 100'000}) {
+    fdt_benchmarks(nof_entries);
+  }
+  return 0;
+}
@@ -0,0 +1,132 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include <atomic>              // for atomic
+#include <chrono>              // for steady_clock
+#include <cstdio>              // for printf
+#include <cstdlib>             // for malloc, free, strtoull
+#include <new>                 // for bad_alloc
+#include <vector>              // for vector
+#include "AlcPacket.h"         // for AlcPacket
+#include "EncodingSymbol.h"    // for EncodingSymbol
+#include "File.h"              // for File
+#include "ReceiverBase.h"      // for ReceiverBase
+#include "flute_types.h"       // for FecOti, FecScheme
+#include "spdlog/spdlog.h"     // for set_level
+
+static std::atomic<uint64_t> allocations{0};
+
+void* operator new(size_t size) {
+  allocations++;
+  void* ptr = malloc(size);
+  if (ptr == nullptr) {
+    throw std::bad_alloc();
+  }
+  return ptr;
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t /*size*/) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t /*size*/) noexcept { free(ptr); }
+
+/**
+ *  Exposes the packet handler of ReceiverBase, without any socket
+ */
+class BenchReceiver : public LibFlute::ReceiverBase {
+  public:
+    explicit BenchReceiver(uint64_t tsi) : ReceiverBase("238.1.1.95", 40085, tsi) {}
+    void stop() override {}
+    using ReceiverBase::handle_received_packet;
+};
+
+/**
+ *  Feed pre-generated ALC packets through ReceiverBase::handle_received_packet and count
+ *  heap allocations (through operator new) while objects are in progress.
+ *  Objects are started from in-band FEC OTI, so no FDT is required.
+ *
+ *  Usage: receive-path-bench [object size in bytes] [number of objects]
+ *
+ *  @return 0 if no allocations were made in steady state, 1 otherwise
+ */
+auto main(int argc, char **argv) -> int {
+  size_t object_size = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 16 * 1024 * 1024;
+  unsigned nof_objects = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 8;
+  spdlog::set_level(spdlog::level::warn);
+
+  const uint64_t tsi = 16;
+  const uint32_t max_payload = 1428;
+  std::vector<char> content(object_size, 'x');
+  LibFlute::FecOti fec_oti{LibFlute::FecScheme::CompactNoCode, 0, max_payload, 64, {}};
+
+  // Generate the packets for one object
+  std::vector<std::vector<char>> packets;
+  {
+    LibFlute::File file(1, fec_oti, "bench", "application/octet-stream", 0, content.data(), content.size());
+    for (;;) {
+      auto symbols = file.get_next_symbols(max_payload);
+      if (symbols.empty()) {
+        break;
+      }
+      LibFlute::AlcPacket packet(tsi, 1, file.meta().fec_oti, symbols, max_payload, 0, true);
+      packets.emplace_back(packet.data(), packet.data() + packet.size());
+      file.mark_completed(symbols, true);
+    }
+  }
+  if (packets.size() < 3) {
+    printf("Object too small\n");
+    return 1;
+  }
+
+  BenchReceiver receiver(tsi);
+  uint64_t steady_state_allocations = 0;
+  uint64_t steady_state_packets = 0;
+  uint64_t bytes = 0;
+  std::chrono::duration<double> elapsed{};
+
+  for (unsigned object = 0; object < nof_objects; object++) {
+    uint16_t toi = object + 1;
+    for (auto& packet : packets) {
+      packet[10] = (char)(toi >> 8); // TOI is the second half word after CCI
+      packet[11] = (char)(toi & 0xFF);
+    }
+
+    receiver.handle_received_packet(packets.front().data(), packets.front().size()); // creates the File
+
+    auto start = std::chrono::steady_clock::now();
+    auto allocations_before = allocations.load();
+    for (size_t i = 1; i < packets.size() - 1; i++) {
+      receiver.handle_received_packet(packets[i].data(), packets[i].size());
+      bytes += packets[i].size();
+    }
+    steady_state_allocations += allocations.load() - allocations_before;
+    steady_state_packets += packets.size() - 2;
+    elapsed += std::chrono::steady_clock::now() - start;
+
+    receiver.handle_received_packet(packets.back().data(), packets.back().size()); // completes the File
+    receiver.remove_expired_files(0);
+  }
+
+  printf("objects: %u x %zu bytes, %zu packets each\n", nof_objects, object_size, packets.size());
+  printf("steady state: %zu packets, %.0f packets/s, %.1f Mbit/s, %.1f ns/packet\n",
+      (size_t)steady_state_packets,
+      (double)steady_state_packets / elapsed.count(),
+      (double)bytes * 8.0 / elapsed.count() / 1e6,
+      elapsed.count() * 1e9 / (double)steady_state_packets);
+  printf("steady state heap allocations: %zu (%.3f per packet)\n",
+      (size_t)steady_state_allocations, (double)steady_state_allocations / (double)steady_state_packets);
+
+  return steady_state_allocations == 0 ? 0 : 1;
+}
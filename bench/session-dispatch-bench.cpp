@@ -0,0 +1,127 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include <unistd.h>            // for sysconf
+#include <boost/asio.hpp>      // for io_service
+#include <chrono>              // for steady_clock
+#include <cstdio>              // for printf, fopen
+#include <cstdlib>             // for strtoul
+#include <string>              // for string, to_string
+#include <vector>              // for vector
+#include "AlcPacket.h"         // for AlcPacket
+#include "File.h"              // for File
+#include "SessionManager.h"    // for SessionManager
+#include "flute_types.h"       // for FecOti, FecScheme
+#include "spdlog/spdlog.h"     // for set_level
+
+/**
+ *  Resident set size of the process in bytes
+ */
+static auto resident_bytes() -> size_t {
+  size_t pages = 0;
+  size_t resident = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm != nullptr) {
+    if (fscanf(statm, "%zu %zu", &pages, &resident) != 2) {
+      resident = 0;
+    }
+    fclose(statm);
+  }
+  return resident * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+static auto group_address(unsigned index) -> std::string {
+  return "239.10." + std::to_string(index / 250) + "." + std::to_string(index % 250 + 1);
+}
+
+/**
+ *  Measure the cost of dispatching packets to their sessions in SessionManager as the number of
+ *  joined multicast groups grows, and the user space memory used per session.
+ *
+ *  Packets are sent over loopback in bursts spread over all groups, and the time spent in the
+ *  io_service to receive and dispatch them is measured. The packets belong to an unknown object,
+ *  so they are discarded after the session's file table lookup and no decoding is included.
+ *
+ *  Usage: session-dispatch-bench [max. sessions] [packets per run]
+ */
+auto main(int argc, char **argv) -> int {
+  unsigned max_sessions = (argc > 1) ? strtoul(argv[1], nullptr, 10) : 4096;
+  unsigned nof_packets = (argc > 2) ? strtoul(argv[2], nullptr, 10) : 100000;
+  spdlog::set_level(spdlog::level::warn);
+
+  const uint64_t tsi = 16;
+  const unsigned short port = 40400;
+  const unsigned burst = 64;
+
+  // a packet of an object that none of the sessions receives
+  std::vector<char> content(1428, 'x');
+  LibFlute::FecOti fec_oti{LibFlute::FecScheme::CompactNoCode, 0, 1428, 64, {}};
+  LibFlute::File file(999, fec_oti, "bench", "application/octet-stream", 0, content.data(), content.size());
+  LibFlute::AlcPacket packet(tsi, 999, file.meta().fec_oti, file.get_next_symbols(1428), 1428, 0);
+
+  printf("%10s %14s %14s %12s %14s\n", "sessions", "received", "ns/packet", "packets/s", "bytes/session");
+  for (unsigned nof_sessions = 1; nof_sessions <= max_sessions; nof_sessions *= 4) {
+    boost::asio::io_service io;
+    {
+      // set up the reactor and logging before measuring the memory of the sessions
+      LibFlute::SessionManager warm_up("0.0.0.0", io);
+      warm_up.join(group_address(max_sessions), port, tsi);
+      io.poll();
+    }
+    io.poll();
+    io.restart(); // the io_service stops when it runs out of work
+    auto rss_before = resident_bytes();
+    LibFlute::SessionManager manager("0.0.0.0", io);
+    for (unsigned i = 0; i < nof_sessions; i++) {
+      manager.join(group_address(i), port, tsi);
+    }
+    io.poll(); // start waiting on all sockets
+    auto rss_per_session = (resident_bytes() - rss_before) / nof_sessions;
+
+    boost::asio::ip::udp::socket sender(io, boost::asio::ip::udp::v4());
+    sender.set_option(boost::asio::ip::multicast::enable_loopback(true));
+    std::vector<boost::asio::ip::udp::endpoint> endpoints;
+    for (unsigned i = 0; i < nof_sessions; i++) {
+      endpoints.emplace_back(boost::asio::ip::address::from_string(group_address(i)), port);
+    }
+
+    std::chrono::duration<double> elapsed{};
+    uint64_t sent = 0;
+    unsigned next = 0;
+    while (sent < nof_packets) {
+      for (unsigned i = 0; i < burst; i++) {
+        sender.send_to(boost::asio::buffer(packet.data(), packet.size()), endpoints[next]);
+        next = (next + 1) % nof_sessions;
+      }
+      sent += burst;
+
+      // receive and dispatch the burst
+      auto start = std::chrono::steady_clock::now();
+      while (io.poll() > 0 && manager.packets() < sent) {
+      }
+      elapsed += std::chrono::steady_clock::now() - start;
+    }
+
+    auto received = manager.packets();
+    printf("%10u %14lu %14.1f %12.0f ", nof_sessions, (unsigned long)received,
+        elapsed.count() * 1e9 / (double)received, (double)received / elapsed.count());
+    if (nof_sessions >= 64) {
+      printf("%14zu\n", rss_per_session);
+    } else {
+      printf("%14s\n", "-"); // below the page granularity of the RSS
+    }
+  }
+  return 0;
+}
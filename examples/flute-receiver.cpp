@@ -13,14 +13,14 @@
 // See the License for the specific language governing permissions and limitations
 // under the License.
 //
-#include <argp.h>                          // for argp_parse, ARGP_ERR_UNKNOWN
+#include <argp.h>                          // for argp_parse, argp_error, ARGP_ERR_UNKNOWN
 #include <spdlog/common.h>                 // for level_enum
 #include <cstring>                         // for strrchr
 #include <syslog.h>                        // for LOG_CONS, LOG_PERROR, LOG_PID
 #include <boost/asio/impl/io_context.ipp>  // for io_context::io_context
 #include <boost/asio/io_service.hpp>       // for io_service
 #include <cstdio>                          // for snprintf, FILE, fclose, fopen
-#include <cstdlib>                         // for strtoul, calloc, free
+#include <cstdlib>                         // for strtoul, strtol, strtod, calloc, free
 #include <exception>                       // for exception
 #include <memory>                          // for shared_ptr, __shared_ptr_a...
 #include <string>                          // for to_string, allocator, string
@@ -29,6 +29,10 @@
 #include "ReceiverBase.h"                      // for Receiver
 #include "Receiver.h"                      // for Receiver
 #include "PcapReceiver.h"                  // for Receiver
+#include "ShardedReceiver.h"               // for ShardedReceiver
+#include "AfPacketReceiver.h"              // for AfPacketReceiver
+#include "AfXdpReceiver.h"                 // for AfXdpReceiver
+#include "LivePcapReceiver.h"              // for LivePcapReceiver
 #include "Version.h"                       // for VERSION_MAJOR, VERSION_MINOR
 #include "spdlog/sinks/syslog_sink.h"      // for syslog_logger_mt
 #include "spdlog/spdlog.h"                 // for error, info, set_default_l...
@@ -51,7 +55,18 @@ static struct argp_option options[] = {  // NOLINT
     {"port", 'p', "PORT", 0, "Multicast port (default: 40085)", 0},
     {"ipsec-key", 'k', "KEY", 0, "To enable IPSec/ESP decryption of packets, provide a hex-encoded AES key here", 0},
     {"capture-file", 'c', "FILE", 0, "Read input packets from a PCAP capture file instead of receiving from the network", 0},
+    {"replay-speed", 's', "SPEED", 0, "Speed multiplier for replaying a capture file, 0 = as fast as possible (default: 1)", 0},
+    {"replay-loops", 'o', "N", 0, "Replay the capture file N times (default: 1)", 0},
+    {"packet-ring", 'a', "IF", 0, "Read input packets from a memory mapped AF_PACKET ring on network interface IF (requires CAP_NET_RAW)", 0},
+    {"capture-interface", 'e', "IF", 0, "Passively capture the session on network interface IF with libpcap, without joining the group (requires CAP_NET_RAW)", 0},
+    {"xdp", 'x', "IF", 0, "Read input packets from queue 0 of network interface IF through an AF_XDP socket (generic XDP mode)", 0},
     {"tsi", 't', "TSI", 0, "TSI to receive (default: 0)", 0},
+    {"batch-size", 'b', "N", 0, "Read up to N datagrams per system call with recvmmsg (default: 1 = no batching)", 0},
+    {"gro", 'g', nullptr, 0, "Enable UDP generic receive offload, if supported by the kernel", 0},
+    {"socket-filter", 'f', nullptr, 0, "Drop packets for other TSIs in the kernel with a BPF socket filter (not with --gro)", 0},
+    {"decode-ring", 'r', "N", 0, "Decode on a separate thread, fed through a ring of N packets (default: 0 = decode on the socket thread)", 0},
+    {"busy-poll", 'u', "CPU", 0, "Receive on a dedicated thread pinned to CPU that busy polls the socket (-1 = no pinning), and report the receive latency on exit", 0},
+    {"threads", 'w', "N", 0, "Decode with N worker threads, each receiving on its own socket (default: 1)", 0},
     {"log-level", 'l', "LEVEL", 0,
      "Log verbosity: 0 = trace, 1 = debug, 2 = info, 3 = warn, 4 = error, 5 = "
      "critical, 6 = none. Default: 2.",
@@ -67,6 +82,11 @@ struct ft_arguments {
   const char *flute_interface = {};  /**< file path of the config file. */
   const char *mcast_target = {};
   const char *capture_file = nullptr;
+  double replay_speed = 1.0;
+  unsigned replay_loops = 1;
+  const char *packet_ring_interface = nullptr;
+  const char *xdp_interface = nullptr;
+  const char *capture_interface = nullptr;
   bool enable_ipsec = false;
   const char *aes_key = {};
   unsigned short mcast_port = 40085;
@@ -75,6 +95,13 @@ struct ft_arguments {
   unsigned nfiles = 0;        /**< log level */
   char **files;
   unsigned tsi = 0;
+  unsigned batch_size = 1;
+  bool enable_gro = false;
+  unsigned nof_threads = 1;
+  unsigned decode_ring_size = 0;
+  bool enable_socket_filter = false;
+  bool enable_busy_poll = false;
+  int busy_poll_cpu = -1;
 };
 
 /**
@@ -86,6 +113,21 @@ static auto parse_opt(int key, char *arg, struct argp_state *state) -> error_t {
     case 'c':
       arguments->capture_file = arg;
       break;
+    case 's':
+      arguments->replay_speed = strtod(arg, nullptr);
+      break;
+    case 'o':
+      arguments->replay_loops = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    case 'a':
+      arguments->packet_ring_interface = arg;
+      break;
+    case 'x':
+      arguments->xdp_interface = arg;
+      break;
+    case 'e':
+      arguments->capture_interface = arg;
+      break;
     case 'm':
       arguments->mcast_target = arg;
       break;
@@ -111,6 +153,31 @@ static auto parse_opt(int key, char *arg, struct argp_state *state) -> error_t {
     case 't':
       arguments->tsi = static_cast<unsigned>(strtoul(arg, nullptr, 10));
       break;
+    case 'b':
+      arguments->batch_size = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    case 'g':
+      arguments->enable_gro = true;
+      break;
+    case 'f':
+      arguments->enable_socket_filter = true;
+      break;
+    case 'r':
+      arguments->decode_ring_size = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    case 'u':
+      arguments->enable_busy_poll = true;
+      arguments->busy_poll_cpu = static_cast<int>(strtol(arg, nullptr, 10));
+      break;
+    case 'w':
+      arguments->nof_threads = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
+    case ARGP_KEY_END:
+      if (arguments->enable_gro && arguments->enable_socket_filter) {
+        // The socket filter only sees the first datagram of a coalesced GRO buffer
+        argp_error(state, "--gro and --socket-filter cannot be combined");
+      }
+      break;
     default:
       return ARGP_ERR_UNKNOWN;
   }
@@ -163,22 +230,130 @@ auto main(int argc, char **argv) -> int {
     boost::asio::io_service io;
 
     std::shared_ptr<LibFlute::ReceiverBase> receiver;
+    std::shared_ptr<LibFlute::ShardedReceiver> sharded_receiver;
+    std::shared_ptr<LibFlute::Receiver> net_receiver;
+
+    auto store_file = [&](std::shared_ptr<LibFlute::File> file) { //NOLINT
+        spdlog::info("{} (TOI {}) has been received",
+            file->meta().content_location, file->meta().toi);
+        char *buf = (char*) calloc(256,1);
+        char *fname = (char*) strrchr(file->meta().content_location.c_str(),'/');
+        if(!fname){
+          fname = (char*) file->meta().content_location.c_str();
+        } else {
+          fname++;
+        }
+        if (arguments.download_dir) {
+          snprintf(buf,256,"%s/%s",arguments.download_dir, fname);
+        } else {
+          snprintf(buf,256,"flute_download_%d-%s",file->meta().toi, fname);
+        }
+        FILE* fd = fopen(buf, "wb");
+        if (fd) {
+          fwrite(file->buffer(), 1, file->length(), fd);
+          fclose(fd);
+        } else {
+          spdlog::error("Error opening file {} to store received object",buf);
+        }
+        free(buf);
+        if (file->meta().toi == arguments.nfiles) {
+          spdlog::warn("{} file(s) received. Stopping reception",arguments.nfiles);
+          if (sharded_receiver) {
+            sharded_receiver->stop();
+          } else {
+            receiver->stop();
+          }
+        }
+        };
 
     // Create the receiver
     if (arguments.capture_file != nullptr) {
       try {
-      receiver = std::make_shared<LibFlute::PcapReceiver>(
+      auto pcap_receiver = std::make_shared<LibFlute::PcapReceiver>(
           arguments.capture_file,
           arguments.mcast_target,
           arguments.mcast_port,
           arguments.tsi,
           io);
+      pcap_receiver->set_replay_speed(arguments.replay_speed);
+      pcap_receiver->set_loops(arguments.replay_loops);
+      receiver = pcap_receiver;
       } catch (std::runtime_error& ex) {
         spdlog::error("PCAP receiver error. {}", ex.what());
         exit(1);
       }
+    } else if (arguments.packet_ring_interface != nullptr) {
+      try {
+      receiver = std::make_shared<LibFlute::AfPacketReceiver>(
+          arguments.packet_ring_interface,
+          arguments.mcast_target,
+          arguments.mcast_port,
+          arguments.tsi,
+          io);
+      } catch (std::runtime_error& ex) {
+        spdlog::error("Packet ring receiver error. {}", ex.what());
+        exit(1);
+      }
+    } else if (arguments.xdp_interface != nullptr) {
+      try {
+      receiver = std::make_shared<LibFlute::AfXdpReceiver>(
+          arguments.xdp_interface,
+          arguments.mcast_target,
+          arguments.mcast_port,
+          arguments.tsi,
+          io);
+      } catch (std::runtime_error& ex) {
+        spdlog::error("AF_XDP receiver error. {}", ex.what());
+        exit(1);
+      }
+    } else if (arguments.capture_interface != nullptr) {
+      try {
+      receiver = std::make_shared<LibFlute::LivePcapReceiver>(
+          arguments.capture_interface,
+          arguments.mcast_target,
+          arguments.mcast_port,
+          arguments.tsi,
+          io);
+      } catch (std::runtime_error& ex) {
+        spdlog::error("Live capture receiver error. {}", ex.what());
+        exit(1);
+      }
+    } else if (arguments.nof_threads > 1) {
+      sharded_receiver = std::make_shared<LibFlute::ShardedReceiver>(
+          arguments.flute_interface,
+          arguments.mcast_target,
+          arguments.mcast_port,
+          arguments.tsi,
+          arguments.nof_threads);
+
+      if (arguments.enable_ipsec) 
+      {
+        sharded_receiver->enable_ipsec(1, arguments.aes_key);
+      }
+
+      if (arguments.batch_size > 1)
+      {
+        sharded_receiver->enable_batched_receive(arguments.batch_size);
+      }
+
+      if (arguments.enable_gro)
+      {
+        sharded_receiver->enable_gro();
+      }
+
+      if (arguments.enable_socket_filter)
+      {
+        sharded_receiver->enable_socket_filter();
+      }
+
+      sharded_receiver->register_completion_callback(store_file);
+
+      // Run the workers until reception is stopped
+      sharded_receiver->start();
+      sharded_receiver->wait();
+      return 0;
     } else {
-      auto net_receiver = std::make_shared<LibFlute::Receiver>(
+      net_receiver = std::make_shared<LibFlute::Receiver>(
           arguments.flute_interface,
           arguments.mcast_target,
           arguments.mcast_port,
@@ -191,41 +366,51 @@ auto main(int argc, char **argv) -> int {
         net_receiver->enable_ipsec(1, arguments.aes_key);
       }
 
+      if (arguments.batch_size > 1)
+      {
+        net_receiver->enable_batched_receive(arguments.batch_size);
+      }
+
+      if (arguments.enable_gro)
+      {
+        net_receiver->enable_gro();
+      }
+
+      if (arguments.enable_socket_filter)
+      {
+        net_receiver->enable_socket_filter();
+      }
+
+      if (arguments.decode_ring_size > 0)
+      {
+        net_receiver->enable_decode_thread(arguments.decode_ring_size);
+      }
+
+      if (arguments.enable_busy_poll)
+      {
+        net_receiver->enable_busy_poll(arguments.busy_poll_cpu);
+      }
+
       receiver = net_receiver;
     }
 
-    receiver->register_completion_callback(
-        [&](std::shared_ptr<LibFlute::File> file) { //NOLINT
-        spdlog::info("{} (TOI {}) has been received",
-            file->meta().content_location, file->meta().toi);
-        char *buf = (char*) calloc(256,1);
-        char *fname = (char*) strrchr(file->meta().content_location.c_str(),'/');
-        if(!fname){
-          fname = (char*) file->meta().content_location.c_str();
-        } else {
-          fname++;
-        }
-        if (arguments.download_dir) {
-          snprintf(buf,256,"%s/%s",arguments.download_dir, fname);
-        } else {
-          snprintf(buf,256,"flute_download_%d-%s",file->meta().toi, fname);
-        }
-        FILE* fd = fopen(buf, "wb");
-        if (fd) {
-          fwrite(file->buffer(), 1, file->length(), fd);
-          fclose(fd);
-        } else {
-          spdlog::error("Error opening file {} to store received object",buf);
-        }
-        free(buf);
-        if (file->meta().toi == arguments.nfiles) {
-          spdlog::warn("{} file(s) received. Stopping reception",arguments.nfiles);
-          receiver->stop();
-        }
-        });
+    receiver->register_completion_callback(store_file);
 
     // Start the IO service
     io.run();
+
+    auto metrics = receiver->metrics();
+    spdlog::info("Received {} packets ({} bytes), {} objects completed, {} expired. Discarded {} packets for other TSIs, "
+        "{} unparseable packets, {} duplicate symbols. {} datagrams dropped by the kernel{}",
+        metrics.packets, metrics.bytes, metrics.completed_objects, metrics.expired_objects, metrics.tsi_mismatches,
+        metrics.parse_errors, metrics.duplicate_symbols, metrics.kernel_drops,
+        arguments.enable_socket_filter ? " (socket buffer overflows and socket filter rejections)" : "");
+
+    if (net_receiver && arguments.enable_busy_poll) {
+      auto latency = net_receiver->latency_statistics();
+      spdlog::info("Receive latency over {} packets: p50 {} ns, p99 {} ns, p99.9 {} ns, max {} ns",
+          latency.count, latency.p50_ns, latency.p99_ns, latency.p999_ns, latency.max_ns);
+    }
   } catch (std::exception ex ) {
     spdlog::error("Exiting on unhandled exception: {}", ex.what());
   }
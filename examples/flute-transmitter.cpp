@@ -29,6 +29,7 @@
 #include <string>                          // for allocator, to_string, string
 #include <vector>                          // for vector
 #include "Transmitter.h"                   // for Transmitter
+#include "PcapTransmitter.h"               // for PcapTransmitter
 #include "Version.h"                       // for VERSION_MAJOR, VERSION_MINOR
 #include "flute_types.h"                   // for FecScheme
 #include "spdlog/sinks/syslog_sink.h"      // for syslog_logger_mt
@@ -53,6 +54,12 @@ static struct argp_option options[] = {  // NOLINT
     {"mtu", 't', "BYTES", 0, "Path MTU to size ALC packets for (default: 1500)", 0},
     {"rate-limit", 'r', "KBPS", 0, "Transmit rate limit (kbps), 0 = no limit, default: 1000 (1 Mbps)", 0},
     {"ipsec-key", 'k', "KEY", 0, "To enable IPSec/ESP encryption of packets, provide a hex-encoded AES key here", 0},
+    {"record", 'w', "FILE", 0, "Write the packets to a PCAP file instead of sending them, and exit when all files are done. Timestamps follow the rate limit", 0},
+    {"replay", 'y', "FILE", 0, "Replay the session on the target address and port from a PCAP capture file, instead of sending files", 0},
+    {"replay-address", 'a', "IP", 0, "Multicast address of the session in the replayed capture (default: the target address)", 0},
+    {"replay-speed", 's', "SPEED", 0, "Speed multiplier for the replay, 0 = as fast as possible (default: 1)", 0},
+    {"replay-loops", 'o', "N", 0, "Replay the capture file N times (default: 1)", 0},
+    {"in-band-fti", 'i', nullptr, 0, "Send the FEC OTI in an EXT_FTI header on every data packet, so receivers can start decoding before the FDT arrives", 0},
     {"log-level", 'l', "LEVEL", 0,
      "Log verbosity: 0 = trace, 1 = debug, 2 = info, 3 = warn, 4 = error, 5 = "
      "critical, 6 = none. Default: 2.",
@@ -71,6 +78,12 @@ struct ft_arguments {
   uint32_t rate_limit = 1000;
   unsigned log_level = 2;        /**< log level */
   unsigned fec = 0;        /**< log level */
+  bool in_band_fti = false;
+  const char *record_file = nullptr;
+  const char *replay_file = nullptr;
+  const char *replay_address = nullptr;
+  double replay_speed = 1.0;
+  unsigned replay_loops = 1;
   char **files;
 };
 
@@ -96,6 +109,24 @@ static auto parse_opt(int key, char *arg, struct argp_state *state) -> error_t {
     case 'r':
       arguments->rate_limit = static_cast<uint32_t>(strtoul(arg, nullptr, 10));
       break;
+    case 'i':
+      arguments->in_band_fti = true;
+      break;
+    case 'w':
+      arguments->record_file = arg;
+      break;
+    case 'y':
+      arguments->replay_file = arg;
+      break;
+    case 'a':
+      arguments->replay_address = arg;
+      break;
+    case 's':
+      arguments->replay_speed = strtod(arg, nullptr);
+      break;
+    case 'o':
+      arguments->replay_loops = static_cast<unsigned>(strtoul(arg, nullptr, 10));
+      break;
     case 'l':
       arguments->log_level = static_cast<unsigned>(strtoul(arg, nullptr, 10));
       break;
@@ -107,7 +138,10 @@ static auto parse_opt(int key, char *arg, struct argp_state *state) -> error_t {
       }
       break;
     case ARGP_KEY_NO_ARGS:
-      argp_usage (state);
+      if (arguments->replay_file == nullptr) {
+        argp_usage (state);
+      }
+      break;
     case ARGP_KEY_ARG:
       arguments->files = &state->argv[state->next-1];
       state->next = state->argc;
@@ -156,6 +190,25 @@ auto main(int argc, char **argv) -> int {
   spdlog::set_default_logger(syslog_logger);
   spdlog::info("FLUTE transmitter demo starting up");
 
+  if (arguments.replay_file != nullptr) {
+    try {
+      boost::asio::io_service io;
+      LibFlute::PcapTransmitter replay(
+          arguments.replay_file,
+          arguments.replay_address != nullptr ? arguments.replay_address : arguments.mcast_target,
+          arguments.mcast_port,
+          io);
+      replay.set_target(arguments.mcast_target, arguments.mcast_port);
+      replay.set_replay_speed(arguments.replay_speed);
+      replay.set_loops(arguments.replay_loops);
+      io.run();
+    } catch (std::exception& ex) {
+      spdlog::error("Replay failed: {}", ex.what());
+      return -1;
+    }
+    return 0;
+  }
+
   try {
     // We're responsible for buffer management, so create a vector of structs that
     // are going to hold the data buffers
@@ -213,15 +266,27 @@ auto main(int argc, char **argv) -> int {
       transmitter.enable_ipsec(1, arguments.aes_key);
     }
 
+    transmitter.set_in_band_fti(arguments.in_band_fti);
+
+    if (arguments.record_file != nullptr) {
+      transmitter.enable_pcap_recording(arguments.record_file);
+    }
+
     // Register a completion callback
+    size_t nof_transmitted = 0;
     transmitter.register_completion_callback(
-        [&files](uint32_t toi) {
+        [&files, &nof_transmitted, &io, &arguments](uint32_t toi) {
         for (auto& file : files) {
           if (file.toi == toi) { 
             spdlog::info("{} (TOI {}) has been transmitted", file.location,file.toi);
             munmap(file.buffer,file.len);
+            nof_transmitted++;
           }
         }
+        // there is no receiver to keep the session running for when recording
+        if (arguments.record_file != nullptr && nof_transmitted == files.size()) {
+          io.stop();
+        }
         });
 
     // Queue all the files 
@@ -240,6 +305,9 @@ auto main(int argc, char **argv) -> int {
 
     // Start the io_service, and thus sending data
     io.run();
+
+    auto metrics = transmitter.metrics();
+    spdlog::info("Sent {} packets ({} bytes), {} send errors", metrics.packets, metrics.bytes, metrics.send_errors);
   } catch (std::exception ex ) {
     spdlog::error("Exiting on unhandled exception: %s", ex.what());
   }
@@ -0,0 +1,98 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t, uint32_t
+#include <atomic>                     // for atomic
+#include <boost/asio.hpp>             // for io_service
+#include <string>                     // for string
+#include "ReceiverBase.h"
+namespace boost::system { class error_code; }
+
+namespace LibFlute {
+  /**
+   *  FLUTE receiver that reads the multicast traffic of a network interface from a memory mapped
+   *  AF_PACKET ring (TPACKET_V3), and parses the IP and UDP headers itself.
+   *
+   *  The kernel fills whole blocks of packets before handing them over, so there is no system call
+   *  per packet, and the payload is decoded in place in the ring. A BPF filter on the destination
+   *  address and port keeps all other traffic out of the ring.
+   *
+   *  Requires CAP_NET_RAW.
+   */
+  class AfPacketReceiver : public ReceiverBase {
+    public:
+     /**
+      *  Kernel counters of the packet socket
+      */
+      struct Statistics {
+        uint64_t packets;        /**< packets passed by the filter */
+        uint64_t drops;          /**< packets dropped because the ring was full */
+        uint64_t freeze_count;   /**< times the ring was completely full */
+      };
+
+     /**
+      *  Default constructor.
+      *
+      *  @param iface Name of the network interface to capture on (e.g. eth0)
+      *  @param address Multicast address
+      *  @param port Target port
+      *  @param tsi TSI value of the session
+      *  @param io_service Boost io_service to run the ring handling in (must be provided by the caller)
+      *  @param block_size Size of a ring block in bytes, must be a multiple of the page size
+      *  @param nof_blocks Number of blocks in the ring
+      *  @param block_timeout_ms Time after which a block is handed over even if it is not full
+      */
+      AfPacketReceiver( const std::string& iface, const std::string& address,
+          unsigned short port, uint64_t tsi, boost::asio::io_service& io_service,
+          unsigned block_size = 1 << 20, unsigned nof_blocks = 64, unsigned block_timeout_ms = 10);
+
+     /**
+      *  Destructor.
+      */
+      virtual ~AfPacketReceiver();
+
+     /**
+      *  Get the kernel counters. Reading them resets the counters in the kernel, so the values
+      *  are accumulated here.
+      */
+      Statistics statistics();
+
+      void stop() override { _running = false; }
+
+    private:
+      void release();
+      void wait_readable();
+      void handle_readable(const boost::system::error_code& error);
+      void handle_frame(unsigned char* data, size_t len);
+
+      int _fd = -1;
+      int _membership_fd = -1;
+      boost::asio::posix::stream_descriptor _descriptor;
+
+      unsigned char* _ring = nullptr;
+      size_t _ring_size = 0;
+      unsigned _block_size;
+      unsigned _nof_blocks;
+      unsigned _current_block = 0;
+
+      uint32_t _mcast_address_n = 0; // network byte order
+      Statistics _statistics = {0, 0, 0};
+
+      std::atomic<bool> _running = {true};
+  };
+};
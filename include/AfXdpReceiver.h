@@ -0,0 +1,113 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t, uint32_t
+#include <linux/if_xdp.h>             // for xdp_ring_offset
+#include <atomic>                     // for atomic
+#include <boost/asio.hpp>             // for io_service
+#include <string>                     // for string
+#include "ReceiverBase.h"
+namespace boost::system { class error_code; }
+
+namespace LibFlute {
+  /**
+   *  FLUTE receiver that takes the multicast traffic of a network interface queue out of the
+   *  network stack with an AF_XDP socket.
+   *
+   *  A small XDP program redirects unfragmented IPv4/UDP packets (without IP options) to the
+   *  configured group and port into a UMEM area shared with user space. All other traffic is passed
+   *  on to the network stack. The payload is decoded in place in the UMEM frame.
+   *
+   *  The program is attached in generic (SKB) mode, so it works on any interface including veth
+   *  pairs, at the cost of one copy into the UMEM in the kernel. On multi-queue NICs the flow must
+   *  be steered to the configured queue (e.g. with an ethtool ntuple rule).
+   *
+   *  Requires CAP_NET_ADMIN, CAP_NET_RAW and CAP_BPF (or CAP_SYS_ADMIN), and a kernel with
+   *  BPF links for XDP (5.9 or later).
+   */
+  class AfXdpReceiver : public ReceiverBase {
+    public:
+     /**
+      *  Default constructor.
+      *
+      *  @param iface Name of the network interface to receive on (e.g. eth0)
+      *  @param address Multicast address
+      *  @param port Target port
+      *  @param tsi TSI value of the session
+      *  @param io_service Boost io_service to run the ring handling in (must be provided by the caller)
+      *  @param queue_id Receive queue of the interface to bind to
+      *  @param nof_frames Number of UMEM frames, must be a power of two
+      */
+      AfXdpReceiver( const std::string& iface, const std::string& address,
+          unsigned short port, uint64_t tsi, boost::asio::io_service& io_service,
+          unsigned queue_id = 0, unsigned nof_frames = 4096);
+
+     /**
+      *  Destructor. Detaches the XDP program.
+      */
+      virtual ~AfXdpReceiver();
+
+     /**
+      *  Get the number of packets the kernel dropped because the receive ring was full or
+      *  no UMEM frame was available
+      */
+      uint64_t drops();
+
+      void stop() override { _running = false; }
+
+    private:
+      /**
+       *  Single producer / single consumer ring shared with the kernel
+       */
+      struct Ring {
+        uint32_t* producer = nullptr;
+        uint32_t* consumer = nullptr;
+        void* descriptors = nullptr;
+        uint32_t size = 0;
+        void* map = nullptr;
+        size_t map_size = 0;
+      };
+
+      void map_ring(Ring& ring, uint64_t page_offset, uint32_t size, size_t descriptor_size,
+          const struct xdp_ring_offset& offsets);
+      void load_program(uint32_t address, unsigned short port);
+      void release();
+      void wait_readable();
+      void handle_readable(const boost::system::error_code& error);
+      void handle_frame(unsigned char* data, size_t len);
+
+      int _fd = -1;
+      int _map_fd = -1;
+      int _prog_fd = -1;
+      int _link_fd = -1;
+      int _membership_fd = -1;
+      unsigned _ifindex = 0;
+      unsigned _queue_id;
+      boost::asio::posix::stream_descriptor _descriptor;
+
+      unsigned char* _umem = nullptr;
+      size_t _umem_size = 0;
+      unsigned _nof_frames;
+
+      Ring _fill;
+      Ring _completion;
+      Ring _rx;
+
+      std::atomic<bool> _running = {true};
+  };
+};
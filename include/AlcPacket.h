@@ -44,8 +44,9 @@ namespace LibFlute {
       *  @param symbols Vector of encoding symbols
       *  @param max_size Maximum payload size
       *  @param fdt_instance_id FDT instance ID (only relevant for FDT with TOI=0)
+      *  @param include_fti Add an EXT_FTI header extension carrying the FEC OTI (always added for TOI=0)
       */
-      AlcPacket(uint16_t tsi, uint16_t toi, FecOti fec_oti, const std::vector<EncodingSymbol>& symbols, size_t max_size, uint32_t fdt_instance_id);
+      AlcPacket(uint16_t tsi, uint16_t toi, FecOti fec_oti, const std::vector<EncodingSymbol>& symbols, size_t max_size, uint32_t fdt_instance_id, bool include_fti = false);
 
      /**
       *  Default destructor.
@@ -67,6 +68,11 @@ namespace LibFlute {
       */
       const FecOti& fec_oti() const { return _fec_oti; };
 
+     /**
+      *  Check if the packet carried the FEC OTI in an EXT_FTI header extension
+      */
+      bool has_fec_oti() const { return _has_fec_oti; };
+
      /**
       *  Get the LCT header length
       */
@@ -108,6 +114,7 @@ namespace LibFlute {
 
       ContentEncoding _content_encoding = ContentEncoding::NONE;
       FecOti _fec_oti = {};
+      bool _has_fec_oti = false;
 
       char* _buffer = nullptr;
       size_t _len;
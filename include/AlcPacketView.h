@@ -0,0 +1,164 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <cstddef>        // for size_t
+#include <cstdint>        // for uint8_t, uint32_t, uint64_t
+#include "flute_types.h"  // for ContentEncoding, FecOti, FecScheme
+
+namespace LibFlute {
+  /**
+   *  A non-allocating, non-throwing view on the headers of a received ALC packet.
+   *
+   *  The view does not copy the packet. It stores a pointer to the buffer passed to ::parse,
+   *  which must remain valid for as long as the view is used.
+   */
+  class AlcPacketView {
+    public:
+     /**
+      *  Result of parsing a packet
+      */
+      enum class Status {
+        Ok,
+        TooShort,
+        UnsupportedVersion,
+        UnsupportedCci,
+        TsiMissing,
+        ToiMissing,
+        ToiTooLong,
+        UnsupportedFecScheme,
+        MalformedHeaderExtension,
+        InvalidFti,
+        UnsupportedFluteVersion
+      };
+
+     /**
+      *  Get a human readable description of a status code
+      */
+      static const char* status_string(Status status);
+
+     /**
+      *  Read only the TSI from the fixed part of the LCT header.
+      *  This is the cheapest way to reject packets for other sessions.
+      *
+      *  @param data Received data
+      *  @param len Length of the buffer
+      *  @param tsi Set to the TSI if Status::Ok is returned
+      */
+      static Status peek_tsi(const char* data, size_t len, uint64_t& tsi);
+
+     /**
+      *  Parse the LCT header and all header extensions of a packet
+      *
+      *  @param data Received data
+      *  @param len Length of the buffer
+      */
+      Status parse(const char* data, size_t len);
+
+     /**
+      *  Get the TSI
+      */
+      uint64_t tsi() const { return _tsi; };
+
+     /**
+      *  Get the TOI
+      */
+      uint64_t toi() const { return _toi; };
+
+     /**
+      *  Get the FEC scheme (from the codepoint)
+      */
+      FecScheme fec_scheme() const { return _fec_scheme; };
+
+     /**
+      *  Get the LCT header length, which is the offset of the payload
+      */
+      size_t header_length() const { return _header_length; };
+
+     /**
+      *  Get a pointer to the payload
+      */
+      const char* payload() const { return _data + _header_length; };
+
+     /**
+      *  Get the payload length
+      */
+      size_t payload_length() const { return _len - _header_length; };
+
+     /**
+      *  Get the FDT instance ID (only valid if ::has_fdt_instance_id is true)
+      */
+      uint32_t fdt_instance_id() const { return _fdt_instance_id; };
+
+     /**
+      *  Check if the packet has an EXT_FDT header extension
+      */
+      bool has_fdt_instance_id() const { return _fdt_offset != 0; };
+
+     /**
+      *  Get the content encoding from EXT_CENC
+      */
+      ContentEncoding content_encoding() const { return _content_encoding; };
+
+     /**
+      *  Check if the packet carries the FEC OTI in an EXT_FTI header extension
+      */
+      bool has_fec_oti() const { return _fti_offset != 0; };
+
+     /**
+      *  Get the offset of the EXT_FTI header extension, 0 if not present
+      */
+      size_t fti_offset() const { return _fti_offset; };
+
+     /**
+      *  Get the offset of the EXT_FDT header extension, 0 if not present
+      */
+      size_t fdt_offset() const { return _fdt_offset; };
+
+     /**
+      *  Decode the FEC OTI from EXT_FTI. Only valid if ::has_fec_oti is true.
+      */
+      FecOti fec_oti() const;
+
+     /**
+      *  Check if the close object flag is set
+      */
+      bool close_object() const { return _close_object; };
+
+     /**
+      *  Check if the close session flag is set
+      */
+      bool close_session() const { return _close_session; };
+
+    private:
+      const char* _data = nullptr;
+      size_t _len = 0;
+      size_t _header_length = 0;
+
+      uint64_t _tsi = 0;
+      uint64_t _toi = 0;
+      uint32_t _fdt_instance_id = 0;
+
+      FecScheme _fec_scheme = FecScheme::CompactNoCode;
+      ContentEncoding _content_encoding = ContentEncoding::NONE;
+
+      size_t _fti_offset = 0;
+      size_t _fdt_offset = 0;
+
+      bool _close_object = false;
+      bool _close_session = false;
+  };
+};
@@ -0,0 +1,55 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stdint.h>                   // for uint64_t
+#include <atomic>                     // for atomic
+#include <memory>                     // for shared_ptr
+#include <string>                     // for string
+#include "MemoryChannel.h"            // for MemoryChannel
+#include "ReceiverBase.h"
+
+namespace LibFlute {
+  /**
+   *  FLUTE receiver that decodes the packets delivered by a MemoryChannel, for in-process tests and
+   *  benchmarks. Decoding runs on the io_service of the channel.
+   */
+  class ChannelReceiver : public ReceiverBase {
+    public:
+     /**
+      *  Default constructor. Registers the receiver as the sink of the channel, and uses the clock of
+      *  the channel for file expiry.
+      *
+      *  @param channel Channel to receive from
+      *  @param address Multicast address of the session
+      *  @param port Target port of the session
+      *  @param tsi TSI value of the session
+      */
+      ChannelReceiver( std::shared_ptr<MemoryChannel> channel, const std::string& address,
+          unsigned short port, uint64_t tsi);
+
+     /**
+      *  Destructor. Detaches from the channel.
+      */
+      virtual ~ChannelReceiver();
+
+      void stop() override { _running = false; }
+
+    private:
+      std::shared_ptr<MemoryChannel> _channel;
+      std::atomic<bool> _running = {true};
+  };
+};
@@ -0,0 +1,130 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stdint.h>                   // for uint64_t
+#include <boost/asio.hpp>             // for io_service, steady_timer
+#include <chrono>                     // for steady_clock, system_clock
+#include <functional>                 // for function
+#include <memory>                     // for shared_ptr, unique_ptr
+#include <utility>                    // for move
+namespace boost::system { class error_code; }
+
+namespace LibFlute {
+  /**
+   *  Source of time and timers for the timer-driven components (Transmitter, PcapReceiver,
+   *  MemoryChannel and the expiry handling of the receivers).
+   *
+   *  The default, ::system, uses the io_service timers and the system clocks. A VirtualClock
+   *  replaces them with simulated time, so long running scenarios complete in a fraction of the time
+   *  with deterministic results.
+   */
+  class Clock {
+    public:
+      typedef std::chrono::steady_clock::time_point time_point;
+      typedef std::chrono::steady_clock::duration duration;
+
+     /**
+      *  One-shot timer, with the semantics of boost::asio::steady_timer
+      */
+      class Timer {
+        public:
+         /**
+          *  Completion handler for ::async_wait. Called with boost::asio::error::operation_aborted if
+          *  the wait is cancelled.
+          */
+          typedef std::function<void(const boost::system::error_code&)> handler_t;
+
+          virtual ~Timer() = default;
+
+         /**
+          *  Set the expiry time. Cancels a pending wait.
+          */
+          virtual void expires_at(time_point expiry) = 0;
+
+         /**
+          *  Set the expiry time relative to now. Cancels a pending wait.
+          */
+          virtual void expires_after(duration delay) = 0;
+
+         /**
+          *  Wait for the timer to expire. The handler is called on the io_service the timer
+          *  was created for.
+          */
+          virtual void async_wait(handler_t handler) = 0;
+
+         /**
+          *  Cancel a pending wait.
+          */
+          virtual void cancel() = 0;
+      };
+
+     /**
+      *  Default destructor.
+      */
+      virtual ~Clock() = default;
+
+     /**
+      *  Monotonic time, for pacing and time measurements
+      */
+      virtual time_point now() = 0;
+
+     /**
+      *  Wall clock time, for timestamps and expiry
+      */
+      virtual std::chrono::system_clock::time_point system_now() = 0;
+
+     /**
+      *  Create a timer
+      *
+      *  @param io_service Boost io_service to run the completion handlers in
+      */
+      virtual std::unique_ptr<Timer> make_timer(boost::asio::io_service& io_service) = 0;
+
+     /**
+      *  Wall clock time in seconds since the UNIX epoch
+      */
+      uint64_t seconds_since_epoch();
+
+     /**
+      *  Get the clock that uses the system clocks and the io_service timers
+      */
+      static std::shared_ptr<Clock> system();
+  };
+
+  /**
+   *  Clock that uses the system clocks and the io_service timers
+   */
+  class SystemClock : public Clock {
+    public:
+      time_point now() override { return std::chrono::steady_clock::now(); };
+      std::chrono::system_clock::time_point system_now() override { return std::chrono::system_clock::now(); };
+      std::unique_ptr<Timer> make_timer(boost::asio::io_service& io_service) override;
+
+    private:
+      class SteadyTimer : public Timer {
+        public:
+          explicit SteadyTimer(boost::asio::io_service& io_service) : _timer(io_service) {};
+          void expires_at(time_point expiry) override { _timer.expires_at(expiry); };
+          void expires_after(duration delay) override { _timer.expires_after(delay); };
+          void async_wait(handler_t handler) override { _timer.async_wait(std::move(handler)); };
+          void cancel() override { _timer.cancel(); };
+
+        private:
+          boost::asio::steady_timer _timer;
+      };
+  };
+};
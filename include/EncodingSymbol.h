@@ -30,6 +30,12 @@ namespace LibFlute {
        */
       static std::vector<EncodingSymbol> from_payload(char* encoded_data, size_t data_len, const FecOti& fec_oti, ContentEncoding encoding);
 
+      /**
+       *  Parse all encoding symbols from a payload data buffer into an existing vector.
+       *  The vector is cleared first, its capacity is reused.
+       */
+      static void from_payload(char* encoded_data, size_t data_len, const FecOti& fec_oti, ContentEncoding encoding, std::vector<EncodingSymbol>& symbols);
+
       /**
        *  Write encoding symbols to a packet payload buffer
        */
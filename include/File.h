@@ -65,8 +65,10 @@ namespace LibFlute {
 
      /**
       *  Write the data from an encoding symbol into the appropriate place in the buffer
+      *
+      *  @return false if the symbol was not needed (already received, or its block or the file is complete)
       */
-      void put_symbol(const EncodingSymbol& symbol);
+      bool put_symbol(const EncodingSymbol& symbol);
 
      /**
       *  Check if the file is complete
@@ -98,6 +100,11 @@ namespace LibFlute {
       */
       unsigned long received_at() const { return _received_at; };
 
+     /**
+      *  Override the timestamp of file reception, e.g. with the time of a simulated clock
+      */
+      void set_received_at(unsigned long received_at) { _received_at = received_at; };
+
      /**
       *  Log access to the file by incrementing a counter
       */
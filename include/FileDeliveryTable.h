@@ -55,6 +55,11 @@ namespace LibFlute {
       */
       uint32_t instance_id() { return _instance_id; };
 
+     /**
+      *  Get the expiry value of the FDT instance
+      */
+      uint64_t expires() { return _expires; };
+
      /**
       *  An entry for a file in the FDT
       */
@@ -0,0 +1,75 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t
+#include <array>                      // for array
+#include <atomic>                     // for atomic
+
+namespace LibFlute {
+  /**
+   *  Histogram of latencies for a single writer. Buckets are log-linear: every power of two is split
+   *  into 16 buckets, so any latency is kept with a relative precision of 1/16, without a configured range.
+   *
+   *  Recording is wait-free (relaxed atomic increments), so it can be done on the receive path,
+   *  and the statistics can be read from any thread while recording continues.
+   */
+  class LatencyHistogram {
+    public:
+     /**
+      *  Latency percentiles, rounded up to the bucket limit
+      */
+      struct Statistics {
+        uint64_t count;          /**< number of recorded latencies */
+        uint64_t p50_ns;         /**< median */
+        uint64_t p99_ns;         /**< 99th percentile */
+        uint64_t p999_ns;        /**< 99.9th percentile */
+        uint64_t max_ns;         /**< maximum */
+      };
+
+     /**
+      *  Default constructor.
+      */
+      LatencyHistogram() = default;
+
+     /**
+      *  Default destructor.
+      */
+      virtual ~LatencyHistogram() = default;
+
+     /**
+      *  Record a latency. Writer side only.
+      */
+      void record(uint64_t latency_ns);
+
+     /**
+      *  Get the current percentiles. Can be called from any thread.
+      */
+      Statistics statistics() const;
+
+    private:
+      enum { sub_bucket_bits = 4, sub_buckets = 1 << sub_bucket_bits, nof_buckets = 64 * sub_buckets };
+
+      static size_t bucket(uint64_t latency_ns);
+      static uint64_t bucket_limit(size_t bucket);
+      uint64_t percentile(double fraction, uint64_t count) const;
+
+      std::array<std::atomic<uint64_t>, nof_buckets> _buckets = {};
+      std::atomic<uint64_t> _count = {0};
+      std::atomic<uint64_t> _max_ns = {0};
+  };
+};
@@ -0,0 +1,93 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t
+#include <atomic>                     // for atomic
+#include <boost/asio.hpp>             // for io_service
+#include <string>                     // for string
+#include <pcap.h>                     // for pcap_t
+#include "PcapParser.h"               // for PcapParser
+#include "ReceiverBase.h"
+namespace boost::system { class error_code; }
+
+namespace LibFlute {
+  /**
+   *  FLUTE receiver that captures a session from a network interface with libpcap, without joining
+   *  the multicast group. Intended for passive monitoring, e.g. on a mirror port.
+   *
+   *  The capture is opened in immediate mode with a large kernel buffer (a memory mapped ring on
+   *  Linux), and the session filter is applied in the kernel. Packets are read in batches with
+   *  pcap_dispatch whenever the capture becomes readable.
+   *
+   *  Requires CAP_NET_RAW.
+   */
+  class LivePcapReceiver : public ReceiverBase {
+    public:
+     /**
+      *  Capture statistics
+      */
+      struct Statistics {
+        uint64_t packets;        /**< packets of the session passed to the decoder */
+        uint64_t captured;       /**< packets passed by the filter, as counted by libpcap */
+        uint64_t dropped;        /**< packets dropped because the capture buffer was full */
+        uint64_t if_dropped;     /**< packets dropped by the interface or its driver */
+      };
+
+     /**
+      *  Default constructor.
+      *
+      *  @param iface Name of the network interface to capture on (e.g. eth0)
+      *  @param address Multicast address
+      *  @param port Target port
+      *  @param tsi TSI value of the session
+      *  @param io_service Boost io_service to run the capture in (must be provided by the caller)
+      *  @param buffer_size Capture buffer size in bytes
+      *  @param promiscuous Capture in promiscuous mode, required for traffic of groups that are
+      *                     not joined on this host (e.g. on a mirror port)
+      */
+      LivePcapReceiver( const std::string& iface, const std::string& address,
+          unsigned short port, uint64_t tsi, boost::asio::io_service& io_service,
+          size_t buffer_size = 64 * 1024 * 1024, bool promiscuous = true);
+
+     /**
+      *  Destructor.
+      */
+      virtual ~LivePcapReceiver();
+
+     /**
+      *  Get the capture statistics
+      */
+      Statistics statistics();
+
+      void stop() override { _running = false; }
+
+    private:
+      static void handle_frame(unsigned char* user, const struct pcap_pkthdr* header, const unsigned char* data);
+      void wait_readable();
+      void handle_readable(const boost::system::error_code& error);
+
+      pcap_t* _pcap = nullptr;
+      PcapParser _parser;
+      boost::asio::posix::stream_descriptor _descriptor;
+
+      enum { max_packets_per_dispatch = 256 };
+
+      uint64_t _packets = 0;
+      std::atomic<bool> _running = {true};
+  };
+};
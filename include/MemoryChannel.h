@@ -0,0 +1,153 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t
+#include <boost/asio.hpp>             // for io_service
+#include <deque>                      // for deque
+#include <functional>                 // for function
+#include <memory>                     // for shared_ptr, unique_ptr
+#include <mutex>                      // for mutex
+#include <random>                     // for mt19937_64
+#include <vector>                     // for vector
+#include "Clock.h"                    // for Clock
+#include "Transport.h"                // for Transport
+
+namespace LibFlute {
+  /**
+   *  In-process packet channel with configurable impairments, to test FEC and measure throughput
+   *  deterministically without a network (and without root for netem).
+   *
+   *  Packets sent through the channel are copied and delivered to a sink (e.g. a ChannelReceiver) on
+   *  the io_service. Loss, duplication and reordering decisions come from a seeded random number
+   *  generator, so a given sequence of packets is always impaired the same way.
+   */
+  class MemoryChannel : public Transport {
+    public:
+     /**
+      *  Channel impairments. The defaults give a lossless channel without rate limit or delay.
+      */
+      struct Impairments {
+        double loss = 0;                 /**< Bernoulli loss probability, used if gilbert_p_good_bad is 0 */
+        double gilbert_p_good_bad = 0;   /**< Gilbert-Elliott: probability to go from the good to the bad state */
+        double gilbert_p_bad_good = 1;   /**< Gilbert-Elliott: probability to go from the bad to the good state */
+        double gilbert_loss_good = 0;    /**< Gilbert-Elliott: loss probability in the good state */
+        double gilbert_loss_bad = 1;     /**< Gilbert-Elliott: loss probability in the bad state */
+        double duplicate = 0;            /**< probability to deliver a packet twice */
+        double reorder = 0;              /**< probability to hold a packet back */
+        unsigned reorder_distance = 3;   /**< number of packets sent before a held back packet is released */
+        unsigned reorder_timeout_us = 100000; /**< time after which a held back packet is released anyway, if
+                                                   fewer than reorder_distance packets have been sent */
+        uint64_t rate = 0;               /**< link rate in bit/s, 0 = unlimited */
+        unsigned delay_us = 0;           /**< propagation delay */
+        size_t queue_limit = 0;          /**< packets queued for the link before tail drop, 0 = unlimited */
+        uint64_t seed = 1;               /**< random number generator seed */
+      };
+
+     /**
+      *  Channel statistics
+      */
+      struct Statistics {
+        uint64_t sent;           /**< packets passed to ::async_send */
+        uint64_t delivered;      /**< packets passed to the sink, including duplicates */
+        uint64_t lost;           /**< packets dropped by the loss model */
+        uint64_t duplicated;     /**< packets delivered twice */
+        uint64_t reordered;      /**< packets held back */
+        uint64_t queue_dropped;  /**< packets dropped because the queue limit was reached */
+      };
+
+     /**
+      *  Definition of the function packets are delivered to.
+      */
+      typedef std::function<void(char*, size_t)> sink_t;
+
+     /**
+      *  Default constructor. Creates a lossless channel.
+      *
+      *  @param io_service Boost io_service to deliver the packets on (must be provided by the caller)
+      */
+      explicit MemoryChannel(boost::asio::io_service& io_service);
+
+     /**
+      *  Construct a channel with impairments.
+      *
+      *  @param io_service Boost io_service to deliver the packets on (must be provided by the caller)
+      *  @param impairments Channel impairments
+      *  @param clock Clock for the rate limit and delay (default: system clock)
+      */
+      MemoryChannel(boost::asio::io_service& io_service, const Impairments& impairments,
+          std::shared_ptr<Clock> clock = nullptr);
+
+     /**
+      *  Default destructor.
+      */
+      virtual ~MemoryChannel() = default;
+
+     /**
+      *  Set the function packets are delivered to. Packets arriving without a sink are discarded.
+      */
+      void set_sink(sink_t sink);
+
+      void async_send(const char* data, size_t len, send_handler_t handler) override;
+
+     /**
+      *  Get the channel statistics
+      */
+      Statistics statistics();
+
+     /**
+      *  Get the clock of the channel, so that the receiving side can share it
+      */
+      std::shared_ptr<Clock> clock() const { return _clock; };
+
+    private:
+      struct QueuedPacket {
+        Clock::time_point due;
+        std::vector<char> data;
+      };
+      struct HeldPacket {
+        unsigned countdown;
+        Clock::time_point release_at;
+        std::vector<char> data;
+      };
+
+      bool lose_packet();
+      bool chance(double probability);
+      void enqueue(std::vector<char> data, Clock::time_point now);
+      void schedule_delivery();
+      void deliver();
+
+      boost::asio::io_service& _io_service;
+      std::shared_ptr<LibFlute::Clock> _clock;
+      std::unique_ptr<LibFlute::Clock::Timer> _timer;
+      Impairments _impairments;
+
+      std::mt19937_64 _random;
+      std::uniform_real_distribution<double> _uniform = std::uniform_real_distribution<double>(0.0, 1.0);
+      bool _bad_state = false;
+
+      std::deque<QueuedPacket> _queue;
+      std::vector<HeldPacket> _held;
+      Clock::time_point _link_free;
+      bool _delivery_scheduled = false;
+      Clock::time_point _scheduled_at;
+
+      sink_t _sink = nullptr;
+      Statistics _stats = {};
+      std::mutex _mutex;
+  };
+};
@@ -0,0 +1,90 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stdint.h>                   // for uint64_t
+#include <atomic>                     // for atomic, atomic_thread_fence
+
+namespace LibFlute {
+  /**
+   *  Counter with a single writer. Updates are a relaxed load and store instead of an atomic
+   *  read-modify-write, so counting on the packet path costs about as much as incrementing a plain
+   *  integer. Can be read from any thread.
+   */
+  class Counter {
+    public:
+     /**
+      *  Add to the counter. Writer side only.
+      */
+      void add(uint64_t value = 1) {
+        _value.store(_value.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+      };
+
+     /**
+      *  Set the counter, e.g. for gauges or counters maintained by the kernel. Writer side only.
+      */
+      void set(uint64_t value) { _value.store(value, std::memory_order_relaxed); };
+
+     /**
+      *  Get the current value. Can be called from any thread.
+      */
+      uint64_t value() const { return _value.load(std::memory_order_relaxed); };
+
+    private:
+      std::atomic<uint64_t> _value = {0};
+  };
+
+  /**
+   *  Sequence lock to read a group of Counters with a single writer as a consistent snapshot.
+   *
+   *  The writer brackets each group of related updates with ::write_begin and ::write_end and never
+   *  waits. A reader copies the counters between ::read_begin and ::read_retry, and starts over if
+   *  an update was in progress. Write sections must be short (a few counter updates), as readers spin
+   *  while one is open.
+   */
+  class SnapshotSequence {
+    public:
+      void write_begin() {
+        _sequence.store(_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+      };
+
+      void write_end() {
+        _sequence.store(_sequence.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+      };
+
+     /**
+      *  @return sequence number to pass to ::read_retry
+      */
+      uint64_t read_begin() const {
+        uint64_t sequence = 0;
+        while (((sequence = _sequence.load(std::memory_order_acquire)) & 1U) != 0) {
+        }
+        return sequence;
+      };
+
+     /**
+      *  @return true if the counters have been updated since ::read_begin, and must be read again
+      */
+      bool read_retry(uint64_t sequence) const {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return _sequence.load(std::memory_order_relaxed) != sequence;
+      };
+
+    private:
+      std::atomic<uint64_t> _sequence = {0};
+  };
+};
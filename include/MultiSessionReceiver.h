@@ -0,0 +1,132 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t
+#include <array>                      // for array
+#include <atomic>                     // for atomic
+#include <boost/asio.hpp>             // for io_service
+#include <memory>                     // for shared_ptr
+#include <mutex>                      // for mutex
+#include <string>                     // for string
+#include <unordered_map>              // for unordered_map
+#include <vector>                     // for vector
+#include "ReceiverBase.h"             // for ReceiverBase
+namespace boost::system { class error_code; }
+
+namespace LibFlute {
+  /**
+   *  FLUTE receiver for many sessions sharing one multicast group and port.
+   *
+   *  One socket receives all packets, which are dispatched by TSI to the state of the matching
+   *  session. Every session has its own FDT and file table, and is accessed through the ReceiverBase
+   *  interface (completion callbacks, file list, ...). Sessions can be added and removed at runtime.
+   */
+  class MultiSessionReceiver {
+    public:
+     /**
+      *  Default constructor.
+      *
+      *  @param iface Address of the (local) interface to bind the receiving socket to. 0.0.0.0 = any.
+      *  @param address Multicast address
+      *  @param port Target port
+      *  @param io_service Boost io_service to run the socket operations in (must be provided by the caller)
+      */
+      MultiSessionReceiver( const std::string& iface, const std::string& address,
+          unsigned short port, boost::asio::io_service& io_service);
+
+     /**
+      *  Default destructor.
+      */
+      virtual ~MultiSessionReceiver() = default;
+
+     /**
+      *  Start receiving a session. Can be called from any thread.
+      *
+      *  @param tsi TSI of the session
+      *  @return The session, to register a completion callback or list its files. If a session with
+      *          this TSI already exists, it is returned.
+      */
+      std::shared_ptr<ReceiverBase> add_session(uint64_t tsi);
+
+     /**
+      *  Stop receiving a session and discard its state. Can be called from any thread.
+      *
+      *  @param tsi TSI of the session
+      */
+      void remove_session(uint64_t tsi);
+
+     /**
+      *  Get a session
+      *
+      *  @param tsi TSI of the session
+      *  @return The session, or nullptr if there is no session with this TSI
+      */
+      std::shared_ptr<ReceiverBase> session(uint64_t tsi);
+
+     /**
+      *  Get the TSIs of all sessions
+      */
+      std::vector<uint64_t> session_tsis();
+
+     /**
+      *  Get the number of packets that have been discarded because there was no session for their TSI
+      */
+      uint64_t unknown_tsi_packets() const { return _unknown_tsi_packets; };
+
+     /**
+      *  Stop the receiver
+      */
+      void stop() { _running = false; }
+
+    private:
+      /**
+       *  Reception state of one session
+       */
+      class Session : public ReceiverBase {
+        public:
+          Session(const std::string& address, unsigned short port, uint64_t tsi)
+            : ReceiverBase(address, port, tsi) {};
+          virtual ~Session() = default;
+
+          void handle_packet(char* data, size_t bytes) { if (_running) { handle_received_packet(data, bytes); } };
+          void stop() override { _running = false; }
+
+        private:
+          std::atomic<bool> _running = {true};
+      };
+
+      void start_receive();
+      void handle_receive_from(const boost::system::error_code& error,
+          size_t bytes_recvd);
+
+      std::string _mcast_address;
+      unsigned short _mcast_port;
+
+      std::unordered_map<uint64_t, std::shared_ptr<Session>> _sessions;
+      std::mutex _sessions_mutex;
+      std::atomic<uint64_t> _unknown_tsi_packets = {0};
+
+      boost::asio::ip::udp::socket _socket;
+      boost::asio::ip::udp::endpoint _sender_endpoint;
+
+      enum { max_length = 2048 };
+      std::array<char, max_length> _buffer;
+
+      std::atomic<bool> _running = {true};
+  };
+};
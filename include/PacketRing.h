@@ -0,0 +1,116 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t
+#include <atomic>                     // for atomic
+#include <chrono>                     // for milliseconds
+#include <condition_variable>         // for condition_variable
+#include <mutex>                      // for mutex
+#include <vector>                     // for vector
+
+namespace LibFlute {
+  /**
+   *  Lock-free single producer / single consumer ring of fixed size packet slots.
+   *
+   *  The producer (e.g. the socket thread) copies datagrams into the ring with ::push, the consumer
+   *  reads them in place with ::front and releases the slot with ::pop. Neither side ever blocks
+   *  the other. If the ring is full, the packet is dropped and counted as an overflow.
+   */
+  class PacketRing {
+    public:
+     /**
+      *  Ring statistics
+      */
+      struct Statistics {
+        size_t capacity;         /**< number of slots */
+        size_t occupancy;        /**< slots currently in use */
+        size_t high_watermark;   /**< maximum occupancy seen so far */
+        uint64_t packets;        /**< packets pushed into the ring */
+        uint64_t overflows;      /**< packets dropped because the ring was full */
+        uint64_t oversized;      /**< packets dropped because they were larger than a slot */
+      };
+
+     /**
+      *  Default constructor.
+      *
+      *  @param capacity Number of slots, rounded up to the next power of 2
+      *  @param slot_size Maximum packet length
+      */
+      PacketRing(size_t capacity, size_t slot_size);
+
+     /**
+      *  Default destructor.
+      */
+      virtual ~PacketRing() = default;
+
+     /**
+      *  Copy a packet into the ring. Producer side only.
+      *
+      *  @return false if the packet was dropped
+      */
+      bool push(const char* data, size_t len);
+
+     /**
+      *  Get the oldest packet in the ring without removing it. Consumer side only.
+      *
+      *  @return false if the ring is empty
+      */
+      bool front(char*& data, size_t& len);
+
+     /**
+      *  Release the slot returned by ::front. Consumer side only.
+      */
+      void pop();
+
+     /**
+      *  Wait until the ring is not empty, or the timeout has expired. Consumer side only.
+      *
+      *  @return true if a packet is available
+      */
+      bool wait(std::chrono::milliseconds timeout);
+
+     /**
+      *  Wake up a consumer blocked in ::wait, e.g. when shutting down
+      */
+      void notify();
+
+     /**
+      *  Get the current statistics. Can be called from any thread.
+      */
+      Statistics statistics() const;
+
+    private:
+      size_t _mask;
+      size_t _slot_size;
+      std::vector<char> _buffer;
+      std::vector<size_t> _lengths;
+
+      // written by the consumer, on a cache line of their own to avoid false sharing
+      alignas(64) std::atomic<size_t> _head = {0};
+      // written by the producer
+      alignas(64) std::atomic<size_t> _tail = {0};
+      std::atomic<size_t> _high_watermark = {0};
+      std::atomic<uint64_t> _overflows = {0};
+      std::atomic<uint64_t> _oversized = {0};
+
+      // only used to put an idle consumer to sleep, never taken on the fast path
+      alignas(64) std::atomic<bool> _consumer_waiting = {false};
+      std::mutex _wait_mutex;
+      std::condition_variable _wait_cv;
+  };
+};
@@ -0,0 +1,73 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint32_t
+#include <string>                     // for string
+#include <pcap.h>                     // for pcap_t, pcap_pkthdr
+
+namespace LibFlute {
+  /**
+   *  Extracts the UDP payload of one FLUTE session from captured frames, for receivers that read
+   *  packets through libpcap.
+   *
+   *  Raw IP, Ethernet (with up to two VLAN tags), Linux cooked (v1 and v2) and BSD loopback link
+   *  types are supported. Addresses are compared in binary form, and a BPF filter for the session
+   *  drops all other packets in libpcap (or in the kernel, for live captures).
+   */
+  class PcapParser {
+    public:
+     /**
+      *  Default constructor.
+      *
+      *  @param address Multicast address
+      *  @param port Target port
+      */
+      PcapParser(const std::string& address, unsigned short port);
+
+     /**
+      *  Default destructor.
+      */
+      virtual ~PcapParser() = default;
+
+     /**
+      *  Check the link type of a capture handle, and set the session filter on it.
+      *  Throws if the link type is not supported or the filter can not be set.
+      */
+      void attach(pcap_t* pcap);
+
+     /**
+      *  Get the UDP payload of a captured frame, if it belongs to the session
+      *
+      *  @param header Capture header of the frame
+      *  @param data Captured data
+      *  @param payload Set to the start of the UDP payload
+      *  @param len Set to the length of the UDP payload
+      *  @return false if the frame is not a complete, unfragmented UDP datagram of the session
+      */
+      bool udp_payload(const struct pcap_pkthdr* header, const unsigned char* data,
+          const unsigned char*& payload, size_t& len) const;
+
+    private:
+      bool ip_header_offset(const struct pcap_pkthdr* header, const unsigned char* data, size_t& offset) const;
+
+      std::string _address;
+      unsigned short _port;
+      uint32_t _address_n = 0; // network byte order
+      int _link_type = 0;
+  };
+};
@@ -24,7 +24,9 @@
 #include <mutex>                      // for mutex
 #include <string>                     // for string
 #include <vector>                     // for vector
+#include "Clock.h"                    // for Clock
 #include "FileDeliveryTable.h"        // for FileDeliveryTable
+#include "PcapParser.h"               // for PcapParser
 #include "ReceiverBase.h" 
 #include <pcap.h>
 namespace LibFlute { class File; }
@@ -32,42 +34,95 @@ namespace boost::system { class error_code; }
 
 namespace LibFlute {
   /**
-   *  FLUTE receiver class. Construct an instance of this to receive files from a FLUTE/ALC session.
+   *  FLUTE receiver that replays a FLUTE/ALC session from a PCAP capture file.
+   *
+   *  See PcapParser for the supported link types and the packet filtering.
    */
   class PcapReceiver : public ReceiverBase {
     public:
      /**
-      *  Default constructor.
+      *  Replay statistics
+      */
+      struct Statistics {
+        uint64_t packets;        /**< packets of the session passed to the decoder */
+        uint64_t bytes;          /**< UDP payload bytes of these packets */
+        double seconds;          /**< time since the replay started, until it ended */
+      };
+
+     /**
+      *  Default constructor. The replay starts when the io_service is run.
       *
       *  @param pcap_file Path of the PCAP file to read
       *  @param address Multicast address
       *  @param port Target port 
       *  @param tsi TSI value of the session 
       *  @param io_service Boost io_service to run the socket operations in (must be provided by the caller)
+      *  @param clock Clock for the packet timer, the statistics and file expiry (default: system clock)
       */
       PcapReceiver( const std::string& pcap_file, const std::string& address, 
-          unsigned short port, uint64_t tsi, boost::asio::io_service& io_service, unsigned skip_ms = 0);
+          unsigned short port, uint64_t tsi, boost::asio::io_service& io_service, unsigned skip_ms = 0,
+          std::shared_ptr<Clock> clock = nullptr);
 
      /**
       *  Destructor.
       */
       virtual ~PcapReceiver();
 
+     /**
+      *  Set the replay speed. The gaps between the packets in the capture are divided by the speed.
+      *  Must be called before the io_service is run.
+      *
+      *  @param speed Speed multiplier, e.g. 2.0 for twice as fast. 0 = as fast as possible.
+      */
+      void set_replay_speed(double speed) { _speed = speed; };
+
+     /**
+      *  Replay the capture a number of times. The reception state is reset before every repetition,
+      *  so the same objects are decoded again. Must be called before the io_service is run.
+      *
+      *  @param loops Number of times to replay the file
+      */
+      void set_loops(unsigned loops) { _loops = loops; };
+
+     /**
+      *  Get the replay statistics, e.g. to measure decoding throughput in as fast as possible mode.
+      *  Must be called from the io_service thread, or after the io_service has returned.
+      */
+      Statistics statistics() const;
+
       void stop() override { _running = false; }
 
     private:
       static long tv_to_usecs(const struct timeval *tv);
+      void open_file();
       void process_packet();
       void read_packet();
       void check_packet();
 
       bool _running = true;
-      pcap_t* _pcap_file;
+      std::string _pcap_file_name;
+      pcap_t* _pcap_file = nullptr;
+      PcapParser _parser;
       long _last_packet_time = {};
 
+      double _speed = 1.0;
+      unsigned _loops = 1;
+      unsigned _loop = 0;
+
+      // packets replayed per handler in as fast as possible mode, so the io_service stays responsive
+      enum { max_packets_per_batch = 256 };
+
+      uint64_t _packets = 0;
+      uint64_t _bytes = 0;
+      Clock::time_point _start_time;
+      Clock::time_point _end_time;
+      bool _finished = false;
+
       const unsigned char* _packet_data = nullptr;
       struct pcap_pkthdr _packet_header = {};
 
-      boost::asio::deadline_timer _packet_timer;
+      boost::asio::io_service& _io_service;
+      std::shared_ptr<LibFlute::Clock> _clock;
+      std::unique_ptr<LibFlute::Clock::Timer> _packet_timer;
   };
 };
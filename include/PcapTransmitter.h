@@ -0,0 +1,129 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t
+#include <boost/asio.hpp>             // for io_service
+#include <chrono>                     // for steady_clock
+#include <string>                     // for string
+#include <vector>                     // for vector
+
+namespace LibFlute {
+  /**
+   *  Replays the FLUTE/ALC packets of one session from a PCAP capture file onto a multicast group,
+   *  with the original timing, a multiple of it, or as fast as possible.
+   *
+   *  The UDP payloads of the session are loaded into memory up front (see PcapParser for the supported
+   *  link types), so no file access or parsing happens while sending. Packets that are due at the same
+   *  time are sent in batches with sendmmsg.
+   */
+  class PcapTransmitter {
+    public:
+     /**
+      *  Replay statistics
+      */
+      struct Statistics {
+        uint64_t packets;        /**< packets sent */
+        uint64_t bytes;          /**< UDP payload bytes sent */
+        double seconds;          /**< time since the replay started, until it ended */
+      };
+
+     /**
+      *  Default constructor. Loads the capture, the replay starts when the io_service is run.
+      *
+      *  @param pcap_file Path of the PCAP file to read
+      *  @param address Multicast address of the session in the capture
+      *  @param port Port of the session in the capture
+      *  @param io_service Boost io_service to run the replay in (must be provided by the caller)
+      */
+      PcapTransmitter( const std::string& pcap_file, const std::string& address,
+          unsigned short port, boost::asio::io_service& io_service);
+
+     /**
+      *  Default destructor.
+      */
+      virtual ~PcapTransmitter() = default;
+
+     /**
+      *  Send to a different multicast group or port than the one in the capture.
+      *  Must be called before the io_service is run.
+      *
+      *  @param address Target multicast address
+      *  @param port Target port
+      */
+      void set_target(const std::string& address, unsigned short port);
+
+     /**
+      *  Set the replay speed. The gaps between the packets in the capture are divided by the speed.
+      *  Must be called before the io_service is run.
+      *
+      *  @param speed Speed multiplier, e.g. 2.0 for twice as fast. 0 = as fast as possible.
+      */
+      void set_replay_speed(double speed) { _speed = speed; };
+
+     /**
+      *  Replay the capture a number of times, back to back. Must be called before the io_service is run.
+      *
+      *  @param loops Number of times to replay the file
+      */
+      void set_loops(unsigned loops) { _loops = loops; };
+
+     /**
+      *  Get the replay statistics.
+      *  Must be called from the io_service thread, or after the io_service has returned.
+      */
+      Statistics statistics() const;
+
+     /**
+      *  Stop the replay
+      */
+      void stop() { _running = false; };
+
+    private:
+      struct Packet {
+        size_t offset;           // into _payloads
+        size_t len;
+        long time_us;            // relative to the first packet
+      };
+
+      void load(const std::string& pcap_file, const std::string& address, unsigned short port);
+      void send_next_batch();
+
+      boost::asio::ip::udp::endpoint _endpoint;
+      boost::asio::ip::udp::socket _socket;
+      boost::asio::steady_timer _timer;
+
+      std::vector<char> _payloads;
+      std::vector<Packet> _packets;
+      long _duration_us = 0;
+
+      double _speed = 1.0;
+      unsigned _loops = 1;
+      unsigned _loop = 0;
+      size_t _next = 0;
+      bool _running = true;
+
+      // packets per sendmmsg call, and per handler in as fast as possible mode
+      enum { max_packets_per_batch = 64 };
+
+      uint64_t _sent_packets = 0;
+      uint64_t _sent_bytes = 0;
+      std::chrono::steady_clock::time_point _start_time;
+      std::chrono::steady_clock::time_point _end_time;
+      bool _finished = false;
+  };
+};
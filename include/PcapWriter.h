@@ -0,0 +1,73 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint32_t, uint16_t, uint64_t
+#include <string>                     // for string
+#include <vector>                     // for vector
+#include <pcap.h>                     // for pcap_t, pcap_dumper_t
+
+namespace LibFlute {
+  /**
+   *  Writes UDP payloads to a PCAP file as raw IPv4 packets, with synthetic IP and UDP headers.
+   *  The resulting captures can be read by PcapReceiver.
+   */
+  class PcapWriter {
+    public:
+     /**
+      *  Default constructor.
+      *
+      *  @param file_name Path of the capture file to create
+      *  @param source_address Source IPv4 address to put into the packets
+      *  @param address Destination (multicast) IPv4 address
+      *  @param port Source and destination port
+      */
+      PcapWriter(const std::string& file_name, const std::string& source_address,
+          const std::string& address, unsigned short port);
+
+     /**
+      *  Destructor. Flushes and closes the file.
+      */
+      virtual ~PcapWriter();
+
+     /**
+      *  Write one packet
+      *
+      *  @param payload UDP payload
+      *  @param len Length of the payload
+      *  @param timestamp_us Capture timestamp, in microseconds since the Unix epoch
+      */
+      void write(const char* payload, size_t len, uint64_t timestamp_us);
+
+     /**
+      *  Number of packets written so far
+      */
+      uint64_t packets() const { return _packets; };
+
+    private:
+      pcap_t* _pcap = nullptr;
+      pcap_dumper_t* _dumper = nullptr;
+
+      uint32_t _source_n = 0; // network byte order
+      uint32_t _address_n = 0; // network byte order
+      uint16_t _port;
+      uint16_t _ip_id = 0;
+      uint64_t _packets = 0;
+
+      std::vector<unsigned char> _buffer;
+  };
+};
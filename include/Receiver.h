@@ -17,14 +17,21 @@
 
 #include <stddef.h>                   // for size_t
 #include <stdint.h>                   // for uint64_t, uint32_t
+#include <sys/socket.h>               // for mmsghdr
 #include <boost/asio.hpp>  // for io_service
+#include <atomic>                     // for atomic
 #include <functional>                 // for function
+#include <limits>                     // for numeric_limits
 #include <map>                        // for map
 #include <memory>                     // for shared_ptr, unique_ptr
 #include <mutex>                      // for mutex
 #include <string>                     // for string
+#include <thread>                     // for thread
 #include <vector>                     // for vector
 #include "FileDeliveryTable.h"        // for FileDeliveryTable
+#include "LatencyHistogram.h"         // for LatencyHistogram
+#include "Metrics.h"                  // for Counter
+#include "PacketRing.h"               // for PacketRing
 #include "ReceiverBase.h" 
 namespace LibFlute { class File; }
 namespace boost::system { class error_code; }
@@ -43,14 +50,18 @@ namespace LibFlute {
       *  @param port Target port 
       *  @param tsi TSI value of the session 
       *  @param io_service Boost io_service to run the socket operations in (must be provided by the caller)
+      *  @param reuse_port Set SO_REUSEPORT, so that several receivers (e.g. the workers of a
+      *                    ShardedReceiver) can bind the same port. Other sockets of the same user
+      *                    can then bind it too, and unicast datagrams are spread over all of them.
       */
       Receiver( const std::string& iface, const std::string& address, 
-          unsigned short port, uint64_t tsi, boost::asio::io_service& io_service);
+          unsigned short port, uint64_t tsi, boost::asio::io_service& io_service,
+          bool reuse_port = false);
 
      /**
       *  Default destructor.
       */
-      virtual ~Receiver() = default;
+      virtual ~Receiver();
 
      /**
       *  Enable IPSEC ESP decryption of FLUTE payloads.
@@ -60,17 +71,127 @@ namespace LibFlute {
       */
       void enable_ipsec( uint32_t spi, const std::string& aes_key);
 
-      void stop() override { _running = false; }
+     /**
+      *  Receive up to batch_size datagrams per system call (recvmmsg) instead of one.
+      *  Must be called before the io_service is run, or from its thread.
+      *
+      *  @param batch_size Maximum number of datagrams to read at once. 1 disables batching.
+      */
+      void enable_batched_receive(unsigned batch_size);
+
+     /**
+      *  Enable UDP generic receive offload. The kernel may then coalesce consecutive datagrams of 
+      *  a flow into one buffer, which is split into the individual ALC packets here. 
+      *  Can be combined with ::enable_batched_receive. Must be called before the io_service is run, or from its thread.
+      *
+      *  Cannot be combined with ::enable_socket_filter: the filter runs once per coalesced buffer and
+      *  only sees the first datagram, so it would drop wanted datagrams coalesced behind a foreign one.
+      *
+      *  @return false if the kernel does not support UDP_GRO, or a socket filter is attached. Reception
+      *          continues without it in this case.
+      */
+      bool enable_gro();
+
+     /**
+      *  Attach a BPF socket filter that drops packets for other TSIs in the kernel. If a TOI shard has 
+      *  been set with ::set_toi_shard, packets for other shards are dropped as well.
+      *  TOI restrictions only apply to packets with 32 bit TSI and TOI fields, see SocketFilter::lct_filter.
+      *  Cannot be combined with ::enable_gro (see there).
+      *
+      *  @param min_toi Lowest TOI to receive
+      *  @param max_toi Highest TOI to receive
+      *  @return false if the kernel rejected the filter, or UDP GRO is enabled. All packets are received in this case.
+      */
+      bool enable_socket_filter(uint64_t min_toi = 0, uint64_t max_toi = std::numeric_limits<uint64_t>::max());
+
+     /**
+      *  Decode packets on a separate thread. The socket handler then only copies the received datagrams
+      *  into a lock-free ring, so FEC decoding or a slow completion callback no longer delays draining
+      *  the socket. Packets arriving while the ring is full are dropped and counted.
+      *  Must be called before the io_service is run.
+      *
+      *  @param ring_size Number of packets the ring can hold
+      */
+      void enable_decode_thread(size_t ring_size);
+
+     /**
+      *  Get the occupancy and overflow counters of the decode ring. All values are 0 if 
+      *  ::enable_decode_thread has not been called.
+      */
+      PacketRing::Statistics ring_statistics() const;
+
+     /**
+      *  Receive on a dedicated thread that spins on non-blocking reads instead of sleeping in the
+      *  io_service, for sessions where latency matters more than CPU usage. The socket is set up for
+      *  kernel busy polling (SO_BUSY_POLL, SO_PREFER_BUSY_POLL), so the device queue is polled from
+      *  the receive call as well. Packets are decoded on the polling thread (or pushed to the decode ring,
+      *  if ::enable_decode_thread has been called), and the time from the kernel receive timestamp
+      *  to the return of the packet handler is recorded, see ::latency_statistics.
+      *
+      *  The io_service keeps running until the receiver is stopped. Must be called after all other
+      *  options, and before the io_service is run.
+      *
+      *  @param cpu CPU to pin the polling thread to. -1 = no pinning.
+      *  @param busy_poll_us Time to busy poll the device queue per receive call, in microseconds
+      *  @return false if kernel busy polling is not available (e.g. without CAP_NET_ADMIN). The thread
+      *          still spins on the socket in this case.
+      */
+      bool enable_busy_poll(int cpu = -1, unsigned busy_poll_us = 50);
+
+     /**
+      *  Get the percentiles of the latency from kernel reception to the end of packet handling.
+      *  Only recorded in busy poll mode, see ::enable_busy_poll.
+      */
+      LatencyHistogram::Statistics latency_statistics() const { return _latency.statistics(); };
+
+     /**
+      *  Get a snapshot of the runtime metrics, including the datagrams dropped by the kernel
+      *  (SO_RXQ_OVFL). The kernel counts the packets rejected by ::enable_socket_filter in the same
+      *  counter as the socket buffer overflows, they cannot be told apart.
+      */
+      Metrics metrics() override;
+
+      void stop() override;
 
     private:
+      void start_receive();
+      void restart_receive();
       void handle_receive_from(const boost::system::error_code& error,
           size_t bytes_recvd);
+      void handle_readable(const boost::system::error_code& error);
+      int receive_batch();
+      void setup_batch_buffers();
+      void dispatch_packet(char* data, size_t len);
+      void decode_loop();
+      void poll_loop();
+
       boost::asio::ip::udp::socket _socket;
       boost::asio::ip::udp::endpoint _sender_endpoint;
 
-      enum { max_length = 2048 };
+      enum { max_length = 2048, max_gro_length = 65536 };
       std::array<char, max_length> _buffer;
 
-      bool _running = true;
+      unsigned _batch_size = 1;
+      size_t _batch_buffer_size = max_length;
+      std::vector<char> _batch_buffers;
+      std::vector<char> _batch_control;
+      size_t _batch_control_size = 0;
+      std::vector<struct iovec> _batch_iovecs;
+      std::vector<struct mmsghdr> _batch_msgs;
+
+      bool _gro_enabled = false;
+      bool _socket_filter_enabled = false;
+
+      std::unique_ptr<PacketRing> _ring;
+      std::thread _decode_thread;
+      std::atomic<bool> _decode_running = {false};
+
+      bool _busy_poll = false;
+      std::thread _poll_thread;
+      std::unique_ptr<boost::asio::executor_work_guard<boost::asio::ip::udp::socket::executor_type>> _poll_work;
+      LatencyHistogram _latency;
+      Counter _kernel_drops; // written by the receiving thread
+
+      std::atomic<bool> _running = {true};
   };
 };
@@ -18,14 +18,21 @@
 #include <stddef.h>                   // for size_t
 #include <stdint.h>                   // for uint64_t, uint32_t
 #include <boost/asio.hpp>  // for io_service
+#include <condition_variable>         // for condition_variable
+#include <deque>                      // for deque
 #include <functional>                 // for function
 #include <map>                        // for map
 #include <memory>                     // for shared_ptr, unique_ptr
 #include <mutex>                      // for mutex
 #include <string>                     // for string
+#include <utility>                    // for move
 #include <vector>                     // for vector
+#include "Clock.h"                    // for Clock
+#include "EncodingSymbol.h"           // for EncodingSymbol
 #include "FileDeliveryTable.h"        // for FileDeliveryTable
+#include "Metrics.h"                  // for Counter, SnapshotSequence
 namespace LibFlute { class File; }
+namespace LibFlute { class AlcPacketView; }
 namespace boost::system { class error_code; }
 
 namespace LibFlute {
@@ -42,6 +49,23 @@ namespace LibFlute {
       */
       typedef std::function<void(std::shared_ptr<LibFlute::File>)> completion_callback_t;
 
+     /**
+      *  Runtime metrics, see ::metrics
+      */
+      struct Metrics {
+        uint64_t packets;            /**< packets passed to the decoder */
+        uint64_t bytes;              /**< bytes of these packets */
+        uint64_t tsi_mismatches;     /**< packets discarded because they belong to another TSI */
+        uint64_t parse_errors;       /**< packets discarded because they could not be parsed or decoded */
+        uint64_t duplicate_symbols;  /**< encoding symbols that were not needed any more */
+        uint64_t fdt_instances;      /**< FDT instances received */
+        uint64_t completed_objects;  /**< objects received completely, excluding the FDT */
+        uint64_t expired_objects;    /**< incomplete objects removed by ::remove_expired_files */
+        uint64_t bytes_buffered;     /**< size of the objects in the file list, see ::file_list */
+        uint64_t kernel_drops;       /**< all datagrams the kernel dropped on the socket, i.e. buffer overflows and socket
+                                          filter rejections (Receiver only) */
+      };
+
      /**
       *  Default constructor to be called from derived class.
       *
@@ -80,6 +104,56 @@ namespace LibFlute {
       */
       void register_completion_callback(completion_callback_t cb) { _completion_cb = cb; };
 
+     /**
+      *  Invoke the completion callback on another io_service instead of the receiving thread.
+      *  The callback is posted to the executor, and reception continues without waiting for it.
+      *
+      *  @param executor io_service that runs the callbacks (must be run by the caller)
+      */
+      void set_completion_executor(boost::asio::io_service& executor) { _completion_executor = &executor; };
+
+     /**
+      *  Queue completed files for retrieval with ::next_completed. If the queue is full, the
+      *  oldest file is dropped. The completion callback, if registered, is still invoked.
+      *  Must be called before reception starts.
+      *
+      *  @param max_files Maximum number of files in the queue
+      */
+      void enable_completion_queue(size_t max_files);
+
+     /**
+      *  Get the next completed file from the queue enabled with ::enable_completion_queue
+      *
+      *  @param timeout_ms Time to wait for a file if the queue is empty. 0 = do not wait.
+      *  @return The file, or nullptr if no file has been completed within the timeout
+      */
+      std::shared_ptr<LibFlute::File> next_completed(unsigned timeout_ms = 0);
+
+     /**
+      *  Only decode the objects of one TOI shard. Packets for TOIs with toi % nof_shards != shard are 
+      *  discarded, except for the FDT (TOI 0), which every shard decodes to learn about its files.
+      *  Used to spread the decoding of one session over several receivers without sharing state.
+      *  Must be called before reception starts.
+      *
+      *  @param shard Index of the shard this receiver is responsible for
+      *  @param nof_shards Total number of shards
+      */
+      void set_toi_shard(unsigned shard, unsigned nof_shards);
+
+     /**
+      *  Use another clock for the file and TOI expiry (e.g. a VirtualClock). Must be called before
+      *  reception starts.
+      *
+      *  @param clock Clock to take the reception and delivery times from
+      */
+      void set_clock(std::shared_ptr<Clock> clock) { _clock = std::move(clock); };
+
+     /**
+      *  Get a snapshot of the runtime metrics. The packet counters (packets to completed_objects) are
+      *  consistent with each other. Lock-free, can be called from any thread while reception continues.
+      */
+      virtual Metrics metrics();
+
      /**
       *  Stop the receiver and clean up
       */
@@ -91,15 +165,70 @@ namespace LibFlute {
       */
       void handle_received_packet(char* data, size_t bytes);
 
+     /**
+      *  Forget all files, completed objects and the FDT, so that a repeated transmission of the same
+      *  objects is received again (e.g. when replaying a capture in a loop)
+      */
+      void reset_session();
+
       std::string _mcast_address = {};
       unsigned short _mcast_port = {};
       uint64_t _tsi;
 
+      unsigned _shard = 0;
+      unsigned _nof_shards = 1;
+
     private:
+      std::shared_ptr<LibFlute::File> create_file(const FileDeliveryTable::FileEntry& entry);
+      std::map<uint64_t, std::shared_ptr<LibFlute::File>>::iterator start_in_band_reception(const AlcPacketView& alc);
+      void deliver_file(uint64_t toi);
+      bool already_delivered(uint64_t toi);
+      void prune_completed_objects();
+      void count(Counter& counter, uint64_t value = 1);
+      void update_bytes_buffered();
+      void dispatch_completions(std::vector<std::shared_ptr<LibFlute::File>>& files);
+      bool owns_toi(uint64_t toi) const { return toi == 0 || _nof_shards <= 1 || toi % _nof_shards == _shard; };
+
       std::unique_ptr<LibFlute::FileDeliveryTable> _fdt;
       std::map<uint64_t, std::shared_ptr<LibFlute::File>> _files;
+
+      // Delivered object instances, so that repetitions in the carousel are not received again.
+      // A TOI is only suppressed while the current FDT instance still describes the same object.
+      struct CompletedObject {
+        std::string content_location;
+        std::string content_md5;
+        uint64_t expires;
+      };
+      std::map<uint64_t, CompletedObject> _completed_objects;
+      std::shared_ptr<LibFlute::Clock> _clock = Clock::system();
+
+      // written by the packet handling thread only
+      struct PacketCounters {
+        Counter packets;
+        Counter bytes;
+        Counter tsi_mismatches;
+        Counter parse_errors;
+        Counter duplicate_symbols;
+        Counter fdt_instances;
+        Counter completed_objects;
+      } _counters;
+      SnapshotSequence _counters_sequence;
+
+      // written with _files_mutex held
+      Counter _expired_objects;
+      Counter _bytes_buffered;
       std::mutex _files_mutex;
 
+      std::vector<LibFlute::EncodingSymbol> _symbols; // reused for every packet
+
       completion_callback_t _completion_cb = nullptr;
+      boost::asio::io_service* _completion_executor = nullptr;
+
+      std::vector<std::shared_ptr<LibFlute::File>> _completed_files; // to be dispatched once _files_mutex is released
+
+      size_t _max_queued_files = 0;
+      std::deque<std::shared_ptr<LibFlute::File>> _completion_queue;
+      std::mutex _completion_queue_mutex;
+      std::condition_variable _completion_queue_cv;
   };
 };
@@ -0,0 +1,129 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t
+#include <array>                      // for array
+#include <atomic>                     // for atomic
+#include <boost/asio.hpp>             // for io_service
+#include <map>                        // for map
+#include <memory>                     // for shared_ptr
+#include <mutex>                      // for mutex
+#include <string>                     // for string
+#include <utility>                    // for pair
+#include "ReceiverBase.h"             // for ReceiverBase
+namespace boost::system { class error_code; }
+
+namespace LibFlute {
+  /**
+   *  Receives any number of FLUTE sessions on different multicast groups and ports in one io_service
+   *  (a single epoll loop on Linux).
+   *
+   *  Every session has a socket bound to its group and port, so the kernel sorts the packets, and
+   *  dispatching a packet to its session does not depend on the number of sessions. The sockets only
+   *  wait for readability and are drained into one shared buffer, so a session costs no receive buffer
+   *  of its own in user space. The io_service must therefore be run by a single thread.
+   */
+  class SessionManager {
+    public:
+     /**
+      *  Default constructor.
+      *
+      *  @param iface Address of the (local) interface to join the groups on. 0.0.0.0 = any.
+      *  @param io_service Boost io_service to run the socket operations in (must be provided by the caller)
+      *  @param receive_buffer_size Kernel receive buffer size for each socket. 0 = system default.
+      */
+      SessionManager( const std::string& iface, boost::asio::io_service& io_service,
+          size_t receive_buffer_size = 0);
+
+     /**
+      *  Default destructor. Leaves all groups.
+      */
+      virtual ~SessionManager();
+
+     /**
+      *  Join a multicast group and start receiving a session on it. Can be called from any thread.
+      *
+      *  @param address Multicast address
+      *  @param port Target port
+      *  @param tsi TSI of the session
+      *  @return The session, to register a completion callback or list its files. If the group and
+      *          port have already been joined, the existing session is returned.
+      */
+      std::shared_ptr<ReceiverBase> join(const std::string& address, unsigned short port, uint64_t tsi);
+
+     /**
+      *  Stop receiving a session and leave its multicast group. Can be called from any thread.
+      *
+      *  @param address Multicast address
+      *  @param port Target port
+      */
+      void leave(const std::string& address, unsigned short port);
+
+     /**
+      *  Get a session
+      *
+      *  @return The session, or nullptr if the group and port have not been joined
+      */
+      std::shared_ptr<ReceiverBase> session(const std::string& address, unsigned short port);
+
+     /**
+      *  Get the number of sessions
+      */
+      size_t nof_sessions();
+
+     /**
+      *  Get the number of packets received on all sessions
+      */
+      uint64_t packets() const { return _packets; };
+
+    private:
+      /**
+       *  Reception state and socket of one session
+       */
+      class Session : public ReceiverBase {
+        public:
+          Session(const std::string& address, unsigned short port, uint64_t tsi,
+              boost::asio::io_service& io_service)
+            : ReceiverBase(address, port, tsi)
+            , socket(io_service) {};
+          virtual ~Session() = default;
+
+          void handle_packet(char* data, size_t bytes) { handle_received_packet(data, bytes); };
+          void stop() override { running = false; }
+
+          boost::asio::ip::udp::socket socket;
+          std::atomic<bool> running = {true};
+      };
+
+      void wait_readable(const std::shared_ptr<Session>& session);
+      void handle_readable(const std::shared_ptr<Session>& session, const boost::system::error_code& error);
+
+      boost::asio::io_service& _io_service;
+      boost::asio::ip::address _iface;
+      size_t _receive_buffer_size;
+
+      std::map<std::pair<std::string, unsigned short>, std::shared_ptr<Session>> _sessions;
+      std::mutex _sessions_mutex;
+
+      // all sessions are drained on the io_service thread, so they can share one buffer
+      enum { max_length = 2048, max_packets_per_wakeup = 64 };
+      std::array<char, max_length> _buffer;
+
+      std::atomic<uint64_t> _packets = {0};
+  };
+};
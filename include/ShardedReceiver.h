@@ -0,0 +1,146 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stdint.h>                   // for uint64_t, uint32_t
+#include <boost/asio.hpp>             // for io_service
+#include <memory>                     // for shared_ptr, unique_ptr
+#include <string>                     // for string
+#include <thread>                     // for thread
+#include <vector>                     // for vector
+#include "Receiver.h"                 // for Receiver
+#include "ReceiverBase.h"             // for ReceiverBase::completion_callback_t, ReceiverBase::Metrics
+namespace LibFlute { class File; }
+
+namespace LibFlute {
+  /**
+   *  Multi-threaded FLUTE receiver. Runs a number of workers, each with its own thread, io_service
+   *  and socket bound to the same group and port (SO_REUSEPORT).
+   *
+   *  The kernel delivers a copy of every multicast datagram to each of the sockets. Every worker
+   *  decodes the FDT and the objects of one TOI shard (toi % nof_workers), so each object is
+   *  owned by exactly one worker and decoding never contends for a lock across workers.
+   *
+   *  Only multicast groups are supported: for unicast destinations the kernel would load balance
+   *  the datagrams between the sockets instead of copying them.
+   */
+  class ShardedReceiver {
+    public:
+     /**
+      *  Default constructor.
+      *
+      *  @param iface Address of the (local) interface to bind the receiving sockets to. 0.0.0.0 = any.
+      *  @param address Multicast address
+      *  @param port Target port
+      *  @param tsi TSI value of the session
+      *  @param nof_workers Number of worker threads
+      */
+      ShardedReceiver( const std::string& iface, const std::string& address,
+          unsigned short port, uint64_t tsi, unsigned nof_workers);
+
+     /**
+      *  Default destructor. Stops the workers and waits for their threads to exit.
+      */
+      virtual ~ShardedReceiver();
+
+     /**
+      *  Enable IPSEC ESP decryption of FLUTE payloads.
+      *
+      *  @param spi Security Parameter Index value to use
+      *  @param key AES key as a hex string (without leading 0x). Must be an even number of characters long.
+      */
+      void enable_ipsec( uint32_t spi, const std::string& aes_key);
+
+     /**
+      *  Read up to batch_size datagrams per system call on every worker. Must be called before ::start.
+      */
+      void enable_batched_receive(unsigned batch_size);
+
+     /**
+      *  Enable UDP generic receive offload on every worker. Must be called before ::start.
+      *  Cannot be combined with ::enable_socket_filter, see Receiver::enable_gro.
+      *
+      *  @return false if the kernel does not support UDP_GRO, or the socket filter is attached
+      */
+      bool enable_gro();
+
+     /**
+      *  Attach a BPF socket filter to every worker, so that each socket only queues the packets of
+      *  its own TSI and TOI shard. Must be called before ::start.
+      *  Cannot be combined with ::enable_gro, see Receiver::enable_gro.
+      *
+      *  @return false if the kernel rejected the filter, or UDP GRO is enabled
+      */
+      bool enable_socket_filter();
+
+     /**
+      *  Register a callback for file reception notifications. Must be called before ::start.
+      *  The callback is invoked from the thread of the worker that owns the file, so it must be
+      *  safe to call concurrently.
+      *
+      *  @param cb Function to call on file completion
+      */
+      void register_completion_callback(ReceiverBase::completion_callback_t cb);
+
+     /**
+      *  List all current files of all workers
+      */
+      std::vector<std::shared_ptr<LibFlute::File>> file_list();
+
+     /**
+      *  Remove files from the list that are older than max_age seconds
+      */
+      void remove_expired_files(unsigned max_age);
+
+     /**
+      *  Remove a file from the list that matches the passed content location
+      */
+      void remove_file_with_content_location(const std::string& cl);
+
+     /**
+      *  Get a snapshot of the runtime metrics of every worker
+      */
+      std::vector<ReceiverBase::Metrics> metrics();
+
+     /**
+      *  Start the worker threads
+      */
+      void start();
+
+     /**
+      *  Stop all workers. Can be called from any thread, including a completion callback.
+      */
+      void stop();
+
+     /**
+      *  Block until all worker threads have exited. Must not be called from a worker thread.
+      */
+      void wait();
+
+     /**
+      *  Get the number of workers
+      */
+      unsigned nof_workers() const { return static_cast<unsigned>(_workers.size()); };
+
+    private:
+      struct Worker {
+        std::unique_ptr<boost::asio::io_service> io;
+        std::unique_ptr<LibFlute::Receiver> receiver;
+        std::thread thread;
+      };
+      std::vector<Worker> _workers;
+  };
+};
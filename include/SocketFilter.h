@@ -0,0 +1,75 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stdint.h>                   // for uint16_t, uint32_t, uint64_t
+#include <linux/filter.h>             // for sock_filter
+#include <limits>                     // for numeric_limits
+#include <vector>                     // for vector
+
+namespace LibFlute {
+  /**
+   *  Classic BPF socket filters that drop unwanted ALC packets in the kernel, before they are
+   *  queued on the socket.
+   */
+  class SocketFilter {
+    public:
+     /**
+      *  Packet selection criteria
+      */
+      struct Config {
+        uint64_t tsi = 0;                                       /**< TSI to accept */
+        uint64_t min_toi = 0;                                   /**< lowest TOI to accept */
+        uint64_t max_toi = std::numeric_limits<uint64_t>::max(); /**< highest TOI to accept */
+        unsigned shard = 0;                                     /**< TOI shard to accept (toi % nof_shards) */
+        unsigned nof_shards = 1;                                /**< number of TOI shards, 1 = no sharding */
+      };
+
+     /**
+      *  Generate a filter for UDP sockets that accepts LCT packets (version 1, CCI length 0) for one TSI.
+      *
+      *  TOI range and shard restrictions are only applied to packets with a 32 bit TOI field, other
+      *  TOI lengths are always accepted and left to the receiver to sort out. The FDT (TOI 0) is
+      *  always accepted.
+      *
+      *  @param config Packet selection criteria
+      */
+      static std::vector<struct sock_filter> lct_filter(const Config& config);
+
+     /**
+      *  Generate a filter for packet sockets of type SOCK_DGRAM (data starts at the IP header), that
+      *  accepts unfragmented IPv4/UDP packets to one destination address and port.
+      *
+      *  @param address Destination IPv4 address in host byte order
+      *  @param port Destination UDP port
+      */
+      static std::vector<struct sock_filter> ip_udp_filter(uint32_t address, uint16_t port);
+
+     /**
+      *  Generate a filter that drops all packets, e.g. for a socket that is only used for a group membership
+      */
+      static std::vector<struct sock_filter> drop_all_filter();
+
+     /**
+      *  Attach a filter to a socket
+      *
+      *  @param fd Socket descriptor
+      *  @param filter Filter program
+      *  @return false if the kernel rejected the filter
+      */
+      static bool attach(int fd, const std::vector<struct sock_filter>& filter);
+  };
+};
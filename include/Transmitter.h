@@ -23,9 +23,14 @@
 #include <memory>                         // for shared_ptr, unique_ptr
 #include <mutex>                          // for mutex
 #include <string>                         // for string
+#include "Clock.h"                        // for Clock
+#include "LatencyHistogram.h"             // for LatencyHistogram
+#include "Metrics.h"                      // for Counter, SnapshotSequence
 #include "flute_types.h"                  // for FecScheme, FecScheme::Compa...
 namespace LibFlute { class File; }
 namespace LibFlute { class FileDeliveryTable; }
+namespace LibFlute { class PcapWriter; }
+namespace LibFlute { class Transport; }
 namespace boost::system { class error_code; }
 
 namespace LibFlute {
@@ -42,6 +47,19 @@ namespace LibFlute {
       */
       typedef std::function<void(uint32_t)> completion_callback_t;
 
+     /**
+      *  Runtime metrics, see ::metrics
+      */
+      struct Metrics {
+        uint64_t tsi;                              /**< TSI of the session */
+        uint64_t packets;                          /**< ALC packets sent, including the FDT */
+        uint64_t bytes;                            /**< bytes of these packets */
+        uint64_t send_errors;                      /**< packets the socket or transport failed to send */
+        uint64_t files_queued;                     /**< files being transmitted, excluding the FDT */
+        uint64_t packets_in_flight;                /**< packets handed to the socket or transport, not yet sent */
+        LatencyHistogram::Statistics pacing_lag;   /**< how late the rate limited sends fired */
+      };
+
      /**
       *  Default constructor.
       *
@@ -51,12 +69,14 @@ namespace LibFlute {
       *  @param mtu Path MTU to size FLUTE packets for 
       *  @param rate_limit Transmit rate limit (in kbps)
       *  @param io_service Boost io_service to run the socket operations in (must be provided by the caller)
+      *  @param clock Clock for the send and FDT timers, FDT expiry and recording timestamps (default: system clock)
       */
       Transmitter( const std::string& address, 
           short port, uint64_t tsi, unsigned short mtu,
           uint32_t rate_limit,
           FecScheme _fec_scheme,
-          boost::asio::io_service& io_service);
+          boost::asio::io_service& io_service,
+          std::shared_ptr<Clock> clock = nullptr);
 
      /**
       *  Default destructor.
@@ -71,6 +91,39 @@ namespace LibFlute {
       */
       void enable_ipsec( uint32_t spi, const std::string& aes_key);
 
+     /**
+      *  Carry the FEC OTI in an EXT_FTI header extension on every data packet, not only in the FDT.
+      *  This allows receivers to start decoding an object before they have received the FDT.
+      *
+      *  @param enable Enable or disable in-band FEC OTI
+      */
+      void set_in_band_fti(bool enable) { _in_band_fti = enable; };
+
+     /**
+      *  Send the packets through another transport instead of the UDP socket, e.g. a MemoryChannel.
+      *  The send completions of the transport are handled on the io_service of the Transmitter,
+      *  whichever thread the transport completes them on.
+      *
+      *  @param transport Transport to use, or nullptr for the socket
+      */
+      void set_transport(std::shared_ptr<Transport> transport) { _transport = transport; };
+
+     /**
+      *  Write all generated packets to a PCAP file, as raw IPv4 packets with synthetic IP/UDP headers.
+      *  Only IPv4 targets are supported.
+      *
+      *  If recording only, the socket is not used: packets are generated as fast as possible, and
+      *  their timestamps advance according to the rate limit instead of the wall clock (all packets
+      *  get the same timestamp without a rate limit). Otherwise, packets are sent as usual and recorded
+      *  with the time they were queued.
+      *
+      *  @param file_name Path of the capture file to create
+      *  @param record_only Do not send packets to the network
+      *  @param source_address Source address to put into the IP headers
+      */
+      void enable_pcap_recording(const std::string& file_name, bool record_only = true,
+          const std::string& source_address = "192.0.2.1");
+
      /**
       *  Transmit a file. 
       *  The caller must ensure the data buffer passed here remains valid until the completion callback 
@@ -98,6 +151,12 @@ namespace LibFlute {
       */
       static uint64_t seconds_since_epoch();
 
+     /**
+      *  Get a snapshot of the runtime metrics. The packet counters are consistent with each other.
+      *  Lock-free, can be called from any thread while the transmission continues.
+      */
+      Metrics metrics() const;
+
      /**
       *  Register a callback for file transmission completion notifications
       *
@@ -115,8 +174,9 @@ namespace LibFlute {
       boost::asio::ip::udp::endpoint _endpoint;
       boost::asio::ip::udp::socket _socket;
       boost::asio::io_service& _io_service;
-      boost::asio::deadline_timer _send_timer;
-      boost::asio::deadline_timer _fdt_timer;
+      std::shared_ptr<LibFlute::Clock> _clock;
+      std::unique_ptr<LibFlute::Clock::Timer> _send_timer;
+      std::unique_ptr<LibFlute::Clock::Timer> _fdt_timer;
 
       uint64_t _tsi;
       uint16_t _mtu;
@@ -136,5 +196,23 @@ namespace LibFlute {
       std::string _mcast_address;
 
       uint32_t _rate_limit = 0;
+      bool _in_band_fti = false;
+
+      std::shared_ptr<LibFlute::Transport> _transport;
+      std::unique_ptr<LibFlute::PcapWriter> _pcap_writer;
+      bool _record_only = false;
+      uint64_t _record_time_us = 0;
+
+      // written by the io_service thread only
+      struct PacketCounters {
+        Counter queued;
+        Counter packets;
+        Counter bytes;
+        Counter send_errors;
+        Counter files_queued;
+      } _counters;
+      SnapshotSequence _counters_sequence;
+      LatencyHistogram _pacing_lag;
+      Clock::time_point _next_send_time = {};
   };
 };
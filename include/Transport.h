@@ -0,0 +1,49 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <functional>                 // for function
+namespace boost::system { class error_code; }
+
+namespace LibFlute {
+  /**
+   *  Packet transport for the Transmitter, to replace its UDP socket (e.g. with a MemoryChannel).
+   */
+  class Transport {
+    public:
+     /**
+      *  Completion handler for ::async_send
+      */
+      typedef std::function<void(const boost::system::error_code&)> send_handler_t;
+
+     /**
+      *  Default destructor.
+      */
+      virtual ~Transport() = default;
+
+     /**
+      *  Send a packet. The data must remain valid until the handler has been called.
+      *  The handler may be called on any thread (e.g. the io_service of the transport), but not
+      *  from within ::async_send.
+      *
+      *  @param data Packet payload
+      *  @param len Length of the payload
+      *  @param handler Called once the packet has been sent
+      */
+      virtual void async_send(const char* data, size_t len, send_handler_t handler) = 0;
+  };
+};
@@ -0,0 +1,93 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#pragma once
+
+#include <stddef.h>                   // for size_t
+#include <stdint.h>                   // for uint64_t
+#include <boost/asio.hpp>             // for io_service
+#include <boost/system/error_code.hpp>  // for error_code
+#include <chrono>                     // for system_clock
+#include <map>                        // for map
+#include <memory>                     // for unique_ptr
+#include <utility>                    // for pair
+#include "Clock.h"                    // for Clock
+
+namespace LibFlute {
+  /**
+   *  Simulated clock for tests and benchmarks.
+   *
+   *  Time only advances in ::run_for, which jumps from one timer expiry to the next instead of
+   *  waiting for it. Hours of carousel, expiry and pacing behaviour complete as fast as the
+   *  handlers run, and timers that expire at the same time always fire in the order they were
+   *  started, so a run is reproducible.
+   *
+   *  All components using the clock must share one io_service, which is driven by ::run_for
+   *  instead of io_service::run. Not thread safe: use from the thread that calls ::run_for.
+   */
+  class VirtualClock : public Clock {
+    public:
+     /**
+      *  Default constructor.
+      *
+      *  @param start Wall clock time at the start of the simulation (default: 2021-01-01 00:00:00 UTC)
+      */
+      explicit VirtualClock(std::chrono::system_clock::time_point start =
+          std::chrono::system_clock::time_point(std::chrono::seconds(1609459200)));
+
+     /**
+      *  Default destructor.
+      */
+      virtual ~VirtualClock() = default;
+
+      time_point now() override { return _now; };
+      std::chrono::system_clock::time_point system_now() override;
+      std::unique_ptr<Timer> make_timer(boost::asio::io_service& io_service) override;
+
+     /**
+      *  Advance the simulated time. Runs the ready handlers of the io_service, then fires the timers
+      *  that expire within the duration in order of their expiry, running the handlers they cause
+      *  (e.g. sends and deliveries) at the time of the expiry.
+      *
+      *  @param io_service Boost io_service of the simulated components
+      *  @param duration Simulated time to advance by
+      *  @return number of timer expiries
+      */
+      size_t run_for(boost::asio::io_service& io_service, duration duration);
+
+     /**
+      *  Get the number of pending timer waits
+      */
+      size_t pending() const { return _waits.size(); };
+
+    private:
+      class VirtualTimer;
+      struct Wait {
+        VirtualTimer* timer;
+        Timer::handler_t handler;
+        boost::system::error_code error;
+      };
+
+      void schedule(time_point expiry, VirtualTimer* timer, Timer::handler_t handler,
+          boost::system::error_code error = {});
+      void cancel(VirtualTimer* timer, bool notify);
+      bool fire_next(time_point limit);
+
+      time_point _now = {};
+      std::chrono::system_clock::time_point _start;
+      uint64_t _sequence = 0;
+      std::map<std::pair<time_point, uint64_t>, Wait> _waits; // (expiry, start order) -> wait
+  };
+};
@@ -71,6 +71,14 @@ namespace LibFlute {
      */
     virtual bool parse_fdt_info(tinyxml2::XMLElement *file) = 0;
 
+    /**
+     * @brief Attempt to parse relevent information for decoding from FEC OTI received in-band (EXT_FTI)
+     *
+     * @param fec_oti the FEC OTI values, including the scheme specific info
+     * @return success status
+     */
+    virtual bool parse_fec_oti(const FecOti& fec_oti) = 0;
+
     /**
      * @brief Add relevant information about the FEC Scheme which the decoder may need, to the FDT
      * 
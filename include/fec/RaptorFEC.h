@@ -17,6 +17,7 @@
 
 #include <cstdint>              // for uint16_t, uint32_t
 #include <map>                   // for map
+#include <string>                // for string
 #include "fec/FecTransformer.h"  // for FecTransformer
 #include "flute_types.h"         // for SourceBlock, Symbol
 namespace tinyxml2 { class XMLElement; }
@@ -34,10 +35,12 @@ namespace LibFlute {
 
       LibFlute::SourceBlock create_block(char *buffer, int *bytes_read, int blockid);
 
-      const float surplus_packet_ratio = 1.15; // adds 15% transmission overhead in exchange for protection against up to 15% packet loss. Assuming 1 symbol per packet, for smaller files packets may contain up to 10 symbols per packet but small files are much less vulnerable to packet loss anyways
+      float surplus_packet_ratio = 1.15; // adds 15% transmission overhead in exchange for protection against up to 15% packet loss. Assuming 1 symbol per packet, for smaller files packets may contain up to 10 symbols per packet but small files are much less vulnerable to packet loss anyways
 
       void extract_finished_block(LibFlute::SourceBlock& srcblk, struct dec_context *dc);
 
+      void init_decoder();
+
     public: 
 
       RaptorFEC(unsigned int transfer_length, unsigned int max_payload);
@@ -46,6 +49,12 @@ namespace LibFlute {
 
       ~RaptorFEC();
 
+      /**
+       * @brief Set the number of encoding symbols generated per source block, as a multiple of the number of source symbols K.
+       *        Must be called before create_blocks. Measure the reception overhead with fec-bench before changing the default.
+       */
+      void set_surplus_packet_ratio(float ratio) { surplus_packet_ratio = ratio; }
+
       bool check_source_block_completion(SourceBlock& srcblk);
 
       std::map<uint16_t, SourceBlock> create_blocks(char *buffer, int *bytes_read);
@@ -56,8 +65,15 @@ namespace LibFlute {
 
       bool parse_fdt_info(tinyxml2::XMLElement *file);
 
+      bool parse_fec_oti(const FecOti& fec_oti);
+
       bool add_fdt_info(tinyxml2::XMLElement *file);
 
+      /**
+       * @brief Encode Z, N and Al as the 4 byte scheme specific info (RFC5053 3.2.3)
+       */
+      std::string scheme_specific_info() const;
+
       void *allocate_file_buffer(int min_length);
 
       bool extract_file(std::map<uint16_t, SourceBlock> blocks);
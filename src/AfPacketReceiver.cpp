@@ -0,0 +1,228 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "AfPacketReceiver.h"
+#include <arpa/inet.h>                                              // for inet_pton, ntohs
+#include <linux/if_ether.h>                                         // for ETH_P_IP
+#include <linux/if_packet.h>                                        // for tpacket_req3, TPACKET_V3
+#include <net/if.h>                                                 // for if_nametoindex
+#include <netinet/in.h>                                             // for ip_mreqn
+#include <netinet/ip.h>                                             // for ip
+#include <netinet/udp.h>                                            // for udphdr
+#include <sys/mman.h>                                               // for mmap, munmap
+#include <sys/socket.h>                                             // for socket, setsockopt
+#include <unistd.h>                                                 // for close
+#include <cerrno>                                                   // for errno
+#include <cstring>                                                  // for strerror
+#include <stdexcept>                                                // for runtime_error
+#include <boost/system/error_code.hpp>
+#include "SocketFilter.h"
+#include "spdlog/spdlog.h"
+
+namespace {
+  auto system_error(const std::string& what) -> std::runtime_error
+  {
+    return std::runtime_error(what + ": " + strerror(errno));
+  }
+}
+
+LibFlute::AfPacketReceiver::AfPacketReceiver ( const std::string& iface, const std::string& address,
+    unsigned short port, uint64_t tsi, boost::asio::io_service& io_service,
+    unsigned block_size, unsigned nof_blocks, unsigned block_timeout_ms)
+  : ReceiverBase(address, port, tsi)
+  , _descriptor(io_service)
+  , _block_size(block_size)
+  , _nof_blocks(nof_blocks)
+{
+  auto ifindex = if_nametoindex(iface.c_str());
+  if (ifindex == 0) {
+    throw std::runtime_error("Unknown network interface " + iface);
+  }
+  struct in_addr group = {};
+  if (inet_pton(AF_INET, address.c_str(), &group) != 1) {
+    throw std::runtime_error("Invalid IPv4 multicast address " + address);
+  }
+  _mcast_address_n = group.s_addr;
+
+  // Protocol 0: nothing is queued before the filter is attached and the socket is bound
+  _fd = socket(AF_PACKET, SOCK_DGRAM, 0);
+  if (_fd < 0) {
+    throw system_error("Can't open packet socket");
+  }
+  try {
+    _descriptor.assign(_fd); // closes the socket on destruction
+
+    if (!SocketFilter::attach(_fd, SocketFilter::ip_udp_filter(ntohl(_mcast_address_n), port))) {
+      throw system_error("Can't attach packet filter");
+    }
+
+    int version = TPACKET_V3;
+    if (setsockopt(_fd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0) {
+      throw system_error("TPACKET_V3 is not supported");
+    }
+
+    struct tpacket_req3 req = {};
+    req.tp_block_size = block_size;
+    req.tp_block_nr = nof_blocks;
+    req.tp_frame_size = TPACKET_ALIGNMENT << 7; // only a hint for V3, frames are packed into the blocks
+    req.tp_frame_nr = (block_size * nof_blocks) / req.tp_frame_size;
+    req.tp_retire_blk_tov = block_timeout_ms;
+    req.tp_feature_req_word = 0;
+    if (setsockopt(_fd, SOL_PACKET, PACKET_RX_RING, &req, sizeof(req)) != 0) {
+      throw system_error("Can't set up the packet ring");
+    }
+
+    _ring_size = static_cast<size_t>(block_size) * nof_blocks;
+    auto* ring = mmap(nullptr, _ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_LOCKED, _fd, 0);
+    if (ring == MAP_FAILED) {
+      // locking the ring in memory may exceed RLIMIT_MEMLOCK
+      ring = mmap(nullptr, _ring_size, PROT_READ | PROT_WRITE, MAP_SHARED, _fd, 0);
+      if (ring == MAP_FAILED) {
+        throw system_error("Can't map the packet ring");
+      }
+    }
+    _ring = static_cast<unsigned char*>(ring);
+
+    struct sockaddr_ll sll = {};
+    sll.sll_family = AF_PACKET;
+    sll.sll_protocol = htons(ETH_P_IP);
+    sll.sll_ifindex = static_cast<int>(ifindex);
+    if (bind(_fd, reinterpret_cast<struct sockaddr*>(&sll), sizeof(sll)) != 0) { //NOLINT
+      throw system_error("Can't bind packet socket to " + iface);
+    }
+
+    // Join the group, so the traffic is forwarded to the interface. The membership socket itself
+    // must not queue any packets.
+    _membership_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_membership_fd < 0 || !SocketFilter::attach(_membership_fd, SocketFilter::drop_all_filter())) {
+      throw system_error("Can't open membership socket");
+    }
+    struct ip_mreqn mreq = {};
+    mreq.imr_multiaddr = group;
+    mreq.imr_ifindex = static_cast<int>(ifindex);
+    if (setsockopt(_membership_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+      throw system_error("Can't join multicast group " + address);
+    }
+  } catch (...) {
+    if (!_descriptor.is_open()) {
+      close(_fd);
+    }
+    release();
+    throw;
+  }
+
+  spdlog::info("Receiving {}:{} on {} through a {} x {} byte packet ring", address, port, iface, nof_blocks, block_size);
+  wait_readable();
+}
+
+LibFlute::AfPacketReceiver::~AfPacketReceiver()
+{
+  release();
+}
+
+auto LibFlute::AfPacketReceiver::release() -> void
+{
+  // the packet socket itself is closed by _descriptor
+  if (_ring != nullptr) {
+    munmap(_ring, _ring_size);
+    _ring = nullptr;
+  }
+  if (_membership_fd >= 0) {
+    close(_membership_fd);
+    _membership_fd = -1;
+  }
+}
+
+auto LibFlute::AfPacketReceiver::statistics() -> Statistics
+{
+  struct tpacket_stats_v3 stats = {};
+  socklen_t len = sizeof(stats);
+  if (getsockopt(_fd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) == 0) {
+    _statistics.packets += stats.tp_packets;
+    _statistics.drops += stats.tp_drops;
+    _statistics.freeze_count += stats.tp_freeze_q_cnt;
+  }
+  return _statistics;
+}
+
+auto LibFlute::AfPacketReceiver::wait_readable() -> void
+{
+  // the socket becomes readable when the kernel has handed over a block
+  _descriptor.async_wait(boost::asio::posix::stream_descriptor::wait_read,
+      [this](const boost::system::error_code& error) { handle_readable(error); });
+}
+
+auto LibFlute::AfPacketReceiver::handle_readable(const boost::system::error_code& error) -> void
+{
+  if (!_running || error == boost::asio::error::operation_aborted) {
+    return;
+  }
+  if (error) {
+    spdlog::error("packet ring error: {}", error.message());
+    return;
+  }
+
+  for (;;) {
+    auto* block = reinterpret_cast<struct tpacket_block_desc*>(_ring + static_cast<size_t>(_current_block) * _block_size); //NOLINT
+    if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0) {
+      break;
+    }
+
+    auto* packet = reinterpret_cast<struct tpacket3_hdr*>(reinterpret_cast<unsigned char*>(block) + block->hdr.bh1.offset_to_first_pkt); //NOLINT
+    for (uint32_t i = 0; i < block->hdr.bh1.num_pkts; i++) {
+      // SOCK_DGRAM: the link layer header has already been removed
+      auto* data = reinterpret_cast<unsigned char*>(packet) + packet->tp_net; //NOLINT
+      handle_frame(data, packet->tp_snaplen - (packet->tp_net - packet->tp_mac));
+      packet = reinterpret_cast<struct tpacket3_hdr*>(reinterpret_cast<unsigned char*>(packet) + packet->tp_next_offset); //NOLINT
+    }
+
+    // hand the block back to the kernel
+    __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+    _current_block = (_current_block + 1) % _nof_blocks;
+
+    if (!_running) {
+      return;
+    }
+  }
+
+  wait_readable();
+}
+
+auto LibFlute::AfPacketReceiver::handle_frame(unsigned char* data, size_t len) -> void
+{
+  if (len < sizeof(struct ip)) {
+    return;
+  }
+  auto* ip_header = reinterpret_cast<struct ip*>(data); //NOLINT
+  size_t ip_header_len = ip_header->ip_hl * 4;
+  if (ip_header->ip_v != 4 || ip_header_len < sizeof(struct ip) || len < ip_header_len + sizeof(struct udphdr)) {
+    return;
+  }
+
+  auto* udp_header = reinterpret_cast<struct udphdr*>(data + ip_header_len); //NOLINT
+  if (ip_header->ip_dst.s_addr != _mcast_address_n || ntohs(udp_header->uh_dport) != _mcast_port) {
+    return;
+  }
+
+  // drops truncated packets and the first fragment of fragmented datagrams
+  size_t udp_len = ntohs(udp_header->uh_ulen);
+  if (udp_len < sizeof(struct udphdr) || ip_header_len + udp_len > len) {
+    spdlog::debug("Discarding truncated UDP datagram");
+    return;
+  }
+
+  handle_received_packet(reinterpret_cast<char*>(data + ip_header_len + sizeof(struct udphdr)), //NOLINT
+      udp_len - sizeof(struct udphdr));
+}
@@ -0,0 +1,418 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "AfXdpReceiver.h"
+#include <arpa/inet.h>                                              // for inet_pton, htons
+#include <linux/bpf.h>                                              // for bpf_attr, bpf_insn
+#include <linux/if_ether.h>                                         // for ETH_P_IP, ETH_HLEN
+#include <linux/if_link.h>                                          // for XDP_FLAGS_SKB_MODE
+#include <net/if.h>                                                 // for if_nametoindex
+#include <netinet/in.h>                                             // for ip_mreqn
+#include <netinet/ip.h>                                             // for ip
+#include <netinet/udp.h>                                            // for udphdr
+#include <sys/mman.h>                                               // for mmap, munmap
+#include <sys/socket.h>                                             // for socket, setsockopt
+#include <sys/syscall.h>                                            // for __NR_bpf
+#include <unistd.h>                                                 // for close, syscall
+#include <cerrno>                                                   // for errno
+#include <cstddef>                                                  // for offsetof
+#include <cstring>                                                  // for strerror
+#include <stdexcept>                                                // for runtime_error
+#include <vector>                                                   // for vector
+#include <boost/system/error_code.hpp>
+#include "SocketFilter.h"
+#include "spdlog/spdlog.h"
+
+#ifndef AF_XDP
+#define AF_XDP 44
+#endif
+#ifndef SOL_XDP
+#define SOL_XDP 283
+#endif
+
+namespace {
+  constexpr uint32_t FRAME_SIZE = 4096;
+  constexpr uint32_t COMPLETION_RING_SIZE = 64; // required by the kernel, unused for receiving
+
+  auto system_error(const std::string& what) -> std::runtime_error
+  {
+    return std::runtime_error(what + ": " + strerror(errno));
+  }
+
+  auto bpf(int cmd, union bpf_attr& attr) -> int
+  {
+    return static_cast<int>(syscall(__NR_bpf, cmd, &attr, sizeof(attr)));
+  }
+
+  // Minimal eBPF assembler. All conditional jumps go to the single label "pass".
+  class XdpProgramBuilder {
+    public:
+      enum Reg : uint8_t { R0 = 0, R1, R2, R3, R4, R5, R6 };
+
+      void load(uint8_t size, Reg dst, Reg src, int16_t off) { emit(BPF_LDX | size | BPF_MEM, dst, src, off, 0); };
+      void mov(Reg dst, Reg src) { emit(BPF_ALU64 | BPF_MOV | BPF_X, dst, src, 0, 0); };
+      void mov(Reg dst, int32_t imm) { emit(BPF_ALU64 | BPF_MOV | BPF_K, dst, 0, 0, imm); };
+      void add(Reg dst, int32_t imm) { emit(BPF_ALU64 | BPF_ADD | BPF_K, dst, 0, 0, imm); };
+      void and32(Reg dst, uint32_t imm) { emit(BPF_ALU | BPF_AND | BPF_K, dst, 0, 0, static_cast<int32_t>(imm)); };
+      void call(int32_t helper) { emit(BPF_JMP | BPF_CALL, 0, 0, 0, helper); };
+      void exit() { emit(BPF_JMP | BPF_EXIT, 0, 0, 0, 0); };
+
+      // 32 bit compare, so that immediates with the top bit set are not sign extended
+      void pass_if_ne(Reg dst, uint32_t imm)
+      {
+        _pass_jumps.push_back(_insns.size());
+        emit(BPF_JMP32 | BPF_JNE | BPF_K, dst, 0, 0, static_cast<int32_t>(imm));
+      };
+      void pass_if_gt(Reg dst, Reg src)
+      {
+        _pass_jumps.push_back(_insns.size());
+        emit(BPF_JMP | BPF_JGT | BPF_X, dst, src, 0, 0);
+      };
+
+      void load_map_fd(Reg dst, int fd)
+      {
+        emit(BPF_LD | BPF_DW | BPF_IMM, dst, BPF_PSEUDO_MAP_FD, 0, fd);
+        emit(0, 0, 0, 0, 0);
+      };
+
+      auto build() -> std::vector<struct bpf_insn>
+      {
+        // pass: return XDP_PASS
+        auto pass = _insns.size();
+        mov(R0, XDP_PASS);
+        exit();
+        for (auto i : _pass_jumps) {
+          _insns[i].off = static_cast<int16_t>(pass - i - 1);
+        }
+        return _insns;
+      };
+
+    private:
+      void emit(uint8_t code, uint8_t dst, uint8_t src, int16_t off, int32_t imm)
+      {
+        struct bpf_insn insn = {};
+        insn.code = code;
+        insn.dst_reg = dst & 0xF;
+        insn.src_reg = src & 0xF;
+        insn.off = off;
+        insn.imm = imm;
+        _insns.push_back(insn);
+      };
+
+      std::vector<struct bpf_insn> _insns;
+      std::vector<size_t> _pass_jumps;
+  };
+}
+
+LibFlute::AfXdpReceiver::AfXdpReceiver ( const std::string& iface, const std::string& address,
+    unsigned short port, uint64_t tsi, boost::asio::io_service& io_service,
+    unsigned queue_id, unsigned nof_frames)
+  : ReceiverBase(address, port, tsi)
+  , _queue_id(queue_id)
+  , _descriptor(io_service)
+  , _nof_frames(nof_frames)
+{
+  if (nof_frames == 0 || (nof_frames & (nof_frames - 1)) != 0) {
+    throw std::runtime_error("Number of UMEM frames must be a power of two");
+  }
+  _ifindex = if_nametoindex(iface.c_str());
+  if (_ifindex == 0) {
+    throw std::runtime_error("Unknown network interface " + iface);
+  }
+  struct in_addr group = {};
+  if (inet_pton(AF_INET, address.c_str(), &group) != 1) {
+    throw std::runtime_error("Invalid IPv4 multicast address " + address);
+  }
+
+  _fd = socket(AF_XDP, SOCK_RAW, 0);
+  if (_fd < 0) {
+    throw system_error("Can't open AF_XDP socket");
+  }
+  try {
+    _descriptor.assign(_fd); // closes the socket on destruction
+
+    _umem_size = static_cast<size_t>(nof_frames) * FRAME_SIZE;
+    auto* umem = mmap(nullptr, _umem_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (umem == MAP_FAILED) {
+      throw system_error("Can't allocate UMEM");
+    }
+    _umem = static_cast<unsigned char*>(umem);
+
+    struct xdp_umem_reg umem_reg = {};
+    umem_reg.addr = reinterpret_cast<uint64_t>(_umem); //NOLINT
+    umem_reg.len = _umem_size;
+    umem_reg.chunk_size = FRAME_SIZE;
+    umem_reg.headroom = 0;
+    if (setsockopt(_fd, SOL_XDP, XDP_UMEM_REG, &umem_reg, sizeof(umem_reg)) != 0) {
+      throw system_error("Can't register UMEM");
+    }
+
+    // every frame is either in the fill ring, in the receive ring, or being decoded
+    uint32_t completion_size = COMPLETION_RING_SIZE;
+    if (setsockopt(_fd, SOL_XDP, XDP_UMEM_FILL_RING, &nof_frames, sizeof(nof_frames)) != 0 ||
+        setsockopt(_fd, SOL_XDP, XDP_UMEM_COMPLETION_RING, &completion_size, sizeof(completion_size)) != 0 ||
+        setsockopt(_fd, SOL_XDP, XDP_RX_RING, &nof_frames, sizeof(nof_frames)) != 0) {
+      throw system_error("Can't set up the AF_XDP rings");
+    }
+
+    struct xdp_mmap_offsets offsets = {};
+    socklen_t len = sizeof(offsets);
+    if (getsockopt(_fd, SOL_XDP, XDP_MMAP_OFFSETS, &offsets, &len) != 0) {
+      throw system_error("Can't get the AF_XDP ring offsets");
+    }
+    map_ring(_fill, XDP_UMEM_PGOFF_FILL_RING, nof_frames, sizeof(uint64_t), offsets.fr);
+    map_ring(_completion, XDP_UMEM_PGOFF_COMPLETION_RING, COMPLETION_RING_SIZE, sizeof(uint64_t), offsets.cr);
+    map_ring(_rx, XDP_PGOFF_RX_RING, nof_frames, sizeof(struct xdp_desc), offsets.rx);
+
+    // hand all frames to the kernel
+    auto* fill = static_cast<uint64_t*>(_fill.descriptors);
+    for (uint32_t i = 0; i < nof_frames; i++) {
+      fill[i] = static_cast<uint64_t>(i) * FRAME_SIZE;
+    }
+    __atomic_store_n(_fill.producer, nof_frames, __ATOMIC_RELEASE);
+
+    // generic XDP always copies into the UMEM
+    struct sockaddr_xdp sxdp = {};
+    sxdp.sxdp_family = AF_XDP;
+    sxdp.sxdp_ifindex = _ifindex;
+    sxdp.sxdp_queue_id = queue_id;
+    sxdp.sxdp_flags = XDP_COPY;
+    if (bind(_fd, reinterpret_cast<struct sockaddr*>(&sxdp), sizeof(sxdp)) != 0) { //NOLINT
+      throw system_error("Can't bind AF_XDP socket to " + iface + " queue " + std::to_string(queue_id));
+    }
+
+    load_program(group.s_addr, port);
+
+    // Join the group, so the traffic is forwarded to the interface. The membership socket itself
+    // must not queue any packets.
+    _membership_fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (_membership_fd < 0 || !SocketFilter::attach(_membership_fd, SocketFilter::drop_all_filter())) {
+      throw system_error("Can't open membership socket");
+    }
+    struct ip_mreqn mreq = {};
+    mreq.imr_multiaddr = group;
+    mreq.imr_ifindex = static_cast<int>(_ifindex);
+    if (setsockopt(_membership_fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+      throw system_error("Can't join multicast group " + address);
+    }
+  } catch (...) {
+    if (!_descriptor.is_open()) {
+      close(_fd);
+    }
+    release();
+    throw;
+  }
+
+  spdlog::info("Receiving {}:{} on {} queue {} through AF_XDP with {} UMEM frames", address, port, iface, queue_id, nof_frames);
+  wait_readable();
+}
+
+LibFlute::AfXdpReceiver::~AfXdpReceiver()
+{
+  release();
+}
+
+auto LibFlute::AfXdpReceiver::release() -> void
+{
+  // closing the link detaches the program from the interface. The AF_XDP socket itself is
+  // closed by _descriptor.
+  for (auto* fd : {&_link_fd, &_prog_fd, &_map_fd, &_membership_fd}) {
+    if (*fd >= 0) {
+      close(*fd);
+      *fd = -1;
+    }
+  }
+  for (auto* ring : {&_fill, &_completion, &_rx}) {
+    if (ring->map != nullptr) {
+      munmap(ring->map, ring->map_size);
+      ring->map = nullptr;
+    }
+  }
+  if (_umem != nullptr) {
+    munmap(_umem, _umem_size);
+    _umem = nullptr;
+  }
+}
+
+auto LibFlute::AfXdpReceiver::drops() -> uint64_t
+{
+  struct xdp_statistics stats = {};
+  socklen_t len = sizeof(stats);
+  if (getsockopt(_fd, SOL_XDP, XDP_STATISTICS, &stats, &len) != 0) {
+    return 0;
+  }
+  return stats.rx_dropped + stats.rx_ring_full + stats.rx_fill_ring_empty_descs;
+}
+
+auto LibFlute::AfXdpReceiver::map_ring(Ring& ring, uint64_t page_offset, uint32_t size, size_t descriptor_size,
+    const struct xdp_ring_offset& offsets) -> void
+{
+  ring.size = size;
+  ring.map_size = offsets.desc + size * descriptor_size;
+  ring.map = mmap(nullptr, ring.map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, _fd, static_cast<off_t>(page_offset));
+  if (ring.map == MAP_FAILED) {
+    ring.map = nullptr;
+    throw system_error("Can't map AF_XDP ring");
+  }
+  auto* base = static_cast<unsigned char*>(ring.map);
+  ring.producer = reinterpret_cast<uint32_t*>(base + offsets.producer); //NOLINT
+  ring.consumer = reinterpret_cast<uint32_t*>(base + offsets.consumer); //NOLINT
+  ring.descriptors = base + offsets.desc; //NOLINT
+}
+
+auto LibFlute::AfXdpReceiver::load_program(uint32_t address, unsigned short port) -> void
+{
+  // offsets from the start of the Ethernet frame, for an IPv4 header without options
+  constexpr int16_t ETH_TYPE = 12;
+  constexpr int16_t IP_VERSION_IHL = ETH_HLEN;
+  constexpr int16_t IP_FRAGMENT = ETH_HLEN + 6;
+  constexpr int16_t IP_PROTOCOL = ETH_HLEN + 9;
+  constexpr int16_t IP_DESTINATION = ETH_HLEN + 16;
+  constexpr int16_t UDP_DESTINATION_PORT = ETH_HLEN + 20 + 2;
+  constexpr int32_t HEADERS_LEN = ETH_HLEN + 20 + 8;
+  constexpr uint32_t IPV4_NO_OPTIONS = 0x45;
+  constexpr uint16_t MORE_FRAGMENTS_OFFSET_MASK = 0x3FFF;
+
+  union bpf_attr attr = {};
+  attr.map_type = BPF_MAP_TYPE_XSKMAP;
+  attr.key_size = sizeof(uint32_t);
+  attr.value_size = sizeof(uint32_t);
+  attr.max_entries = _queue_id + 1;
+  _map_fd = bpf(BPF_MAP_CREATE, attr);
+  if (_map_fd < 0) {
+    throw system_error("Can't create XSKMAP");
+  }
+
+  attr = {};
+  uint32_t key = _queue_id;
+  uint32_t value = static_cast<uint32_t>(_fd);
+  attr.map_fd = static_cast<uint32_t>(_map_fd);
+  attr.key = reinterpret_cast<uint64_t>(&key); //NOLINT
+  attr.value = reinterpret_cast<uint64_t>(&value); //NOLINT
+  if (bpf(BPF_MAP_UPDATE_ELEM, attr) != 0) {
+    throw system_error("Can't add the AF_XDP socket to the XSKMAP");
+  }
+
+  // eBPF runs in host byte order, so the packet fields are compared against network order constants
+  using R = XdpProgramBuilder;
+  XdpProgramBuilder p;
+  p.mov(R::R6, R::R1);                                                  // ctx
+  p.load(BPF_W, R::R2, R::R6, offsetof(struct xdp_md, data));
+  p.load(BPF_W, R::R3, R::R6, offsetof(struct xdp_md, data_end));
+  p.mov(R::R4, R::R2);
+  p.add(R::R4, HEADERS_LEN);
+  p.pass_if_gt(R::R4, R::R3);
+  p.load(BPF_H, R::R5, R::R2, ETH_TYPE);
+  p.pass_if_ne(R::R5, htons(ETH_P_IP));
+  p.load(BPF_B, R::R5, R::R2, IP_VERSION_IHL);
+  p.pass_if_ne(R::R5, IPV4_NO_OPTIONS);
+  p.load(BPF_B, R::R5, R::R2, IP_PROTOCOL);
+  p.pass_if_ne(R::R5, IPPROTO_UDP);
+  p.load(BPF_H, R::R5, R::R2, IP_FRAGMENT);
+  p.and32(R::R5, htons(MORE_FRAGMENTS_OFFSET_MASK));
+  p.pass_if_ne(R::R5, 0);
+  p.load(BPF_W, R::R5, R::R2, IP_DESTINATION);
+  p.pass_if_ne(R::R5, address);
+  p.load(BPF_H, R::R5, R::R2, UDP_DESTINATION_PORT);
+  p.pass_if_ne(R::R5, htons(port));
+  // bpf_redirect_map(xskmap, ctx->rx_queue_index, XDP_PASS): packets from other queues go to the stack
+  p.load_map_fd(R::R1, _map_fd);
+  p.load(BPF_W, R::R2, R::R6, offsetof(struct xdp_md, rx_queue_index));
+  p.mov(R::R3, XDP_PASS);
+  p.call(BPF_FUNC_redirect_map);
+  p.exit();
+  auto program = p.build();
+
+  // only helpers that are not GPL-only are used
+  static const char license[] = "5G-MAG Public License";
+  std::string log(4096, '\0');
+  attr = {};
+  attr.prog_type = BPF_PROG_TYPE_XDP;
+  attr.insn_cnt = static_cast<uint32_t>(program.size());
+  attr.insns = reinterpret_cast<uint64_t>(program.data()); //NOLINT
+  attr.license = reinterpret_cast<uint64_t>(license); //NOLINT
+  attr.log_level = 1;
+  attr.log_size = static_cast<uint32_t>(log.size());
+  attr.log_buf = reinterpret_cast<uint64_t>(log.data()); //NOLINT
+  _prog_fd = bpf(BPF_PROG_LOAD, attr);
+  if (_prog_fd < 0) {
+    spdlog::error("XDP program verifier log: {}", log.c_str());
+    throw system_error("Can't load XDP program");
+  }
+
+  attr = {};
+  attr.link_create.prog_fd = static_cast<uint32_t>(_prog_fd);
+  attr.link_create.target_ifindex = _ifindex;
+  attr.link_create.attach_type = BPF_XDP;
+  attr.link_create.flags = XDP_FLAGS_SKB_MODE;
+  _link_fd = bpf(BPF_LINK_CREATE, attr);
+  if (_link_fd < 0) {
+    throw system_error("Can't attach XDP program");
+  }
+}
+
+auto LibFlute::AfXdpReceiver::wait_readable() -> void
+{
+  _descriptor.async_wait(boost::asio::posix::stream_descriptor::wait_read,
+      [this](const boost::system::error_code& error) { handle_readable(error); });
+}
+
+auto LibFlute::AfXdpReceiver::handle_readable(const boost::system::error_code& error) -> void
+{
+  if (!_running || error == boost::asio::error::operation_aborted) {
+    return;
+  }
+  if (error) {
+    spdlog::error("AF_XDP socket error: {}", error.message());
+    return;
+  }
+
+  // we are the only consumer of the receive ring and the only producer of the fill ring
+  auto rx_consumer = *_rx.consumer;
+  auto rx_producer = __atomic_load_n(_rx.producer, __ATOMIC_ACQUIRE);
+  auto fill_producer = *_fill.producer;
+  auto* rx = static_cast<struct xdp_desc*>(_rx.descriptors);
+  auto* fill = static_cast<uint64_t*>(_fill.descriptors);
+
+  for (auto i = rx_consumer; i != rx_producer; i++) {
+    const auto& desc = rx[i & (_rx.size - 1)];
+    handle_frame(_umem + desc.addr, desc.len); //NOLINT
+    fill[fill_producer++ & (_fill.size - 1)] = desc.addr & ~static_cast<uint64_t>(FRAME_SIZE - 1);
+  }
+
+  __atomic_store_n(_fill.producer, fill_producer, __ATOMIC_RELEASE);
+  __atomic_store_n(_rx.consumer, rx_producer, __ATOMIC_RELEASE);
+
+  if (_running) {
+    wait_readable();
+  }
+}
+
+auto LibFlute::AfXdpReceiver::handle_frame(unsigned char* data, size_t len) -> void
+{
+  // the XDP program has already checked the headers up to the UDP destination port
+  constexpr size_t headers_len = ETH_HLEN + sizeof(struct ip) + sizeof(struct udphdr);
+  if (len < headers_len) {
+    return;
+  }
+  auto* udp_header = reinterpret_cast<struct udphdr*>(data + ETH_HLEN + sizeof(struct ip)); //NOLINT
+  size_t udp_len = ntohs(udp_header->uh_ulen);
+  if (udp_len < sizeof(struct udphdr) || ETH_HLEN + sizeof(struct ip) + udp_len > len) {
+    spdlog::debug("Discarding truncated UDP datagram");
+    return;
+  }
+
+  handle_received_packet(reinterpret_cast<char*>(data + headers_len), udp_len - sizeof(struct udphdr)); //NOLINT
+}
@@ -109,6 +109,9 @@ LibFlute::AlcPacket::AlcPacket(char* data, size_t len)
     if (het < 128) {
       hel = *hdr_ptr;
       hdr_ptr += 1;
+      if (hel == 0) {
+        throw "Malformed LCT header extension";
+      }
     }
 
     switch ((AlcPacket::HeaderExtension)het) {
@@ -135,14 +138,30 @@ LibFlute::AlcPacket::AlcPacket(char* data, size_t len)
                           hdr_ptr += 4;
                           break;
                         case FecScheme::Raptor:
-                          //TODO
-                          spdlog::warn("Raptor FEC support in EXT_FTI header extension is still in progress");
-                          throw "Raptor FEC support in EXT_FTI header extension is still in progress";
+                          // RFC5053 3.2.3: F (40 bits), reserved, T (16 bits), Z (16 bits), N (8 bits), Al (8 bits)
+                          if (hel != 4) {
+                            throw "Invalid length for EXT_FTI header extension for Raptor FEC scheme";
+                          }
+                          _fec_oti.transfer_length = (uint64_t)(*(uint8_t*)hdr_ptr) << 32;
+                          hdr_ptr += 1;
+                          {
+                            uint32_t transfer_length_lo = 0; // unaligned
+                            std::memcpy(&transfer_length_lo, hdr_ptr, 4);
+                            _fec_oti.transfer_length |= (uint64_t)(ntohl(transfer_length_lo));
+                          }
+                          hdr_ptr += 4;
+                          hdr_ptr += 1; // reserved
+                          _fec_oti.encoding_symbol_length = ntohs(*(uint16_t*)hdr_ptr);
+                          hdr_ptr += 2;
+                          _fec_oti.scheme_specific_info.assign(hdr_ptr, 4);
+                          hdr_ptr += 4;
+                          hdr_ptr += 2; // padding
                           break;
                         default:
                           throw "Unsupported FEC scheme";
                           break;
                       }
+                      _has_fec_oti = true;
                       break; 
                     }
       case EXT_FDT: {
@@ -169,17 +188,23 @@ LibFlute::AlcPacket::AlcPacket(char* data, size_t len)
                      }
     }
 
-    ext_header_len -= 4;
-    ext_header_len -= hel * 4;
+    // HEL covers the whole extension including HET and HEL, fixed length extensions are one word
+    ext_header_len -= (het < 128) ? hel * 4 : 4;
   }
 }
 
-LibFlute::AlcPacket::AlcPacket(uint16_t tsi, uint16_t toi, LibFlute::FecOti fec_oti, const std::vector<LibFlute::EncodingSymbol>& symbols, size_t max_size, uint32_t fdt_instance_id) // NOLINT
+LibFlute::AlcPacket::AlcPacket(uint16_t tsi, uint16_t toi, LibFlute::FecOti fec_oti, const std::vector<LibFlute::EncodingSymbol>& symbols, size_t max_size, uint32_t fdt_instance_id, bool include_fti) // NOLINT
   : _fec_oti(std::move(fec_oti))
 {
+  if (toi == 0) { // The FDT always carries its OTI in-band
+    include_fti = true;
+  }
   auto lct_header_len = 3;
-  if (toi == 0) { // Add extensions for FDT
-    lct_header_len += 5;
+  if (toi == 0) { // Add EXT_FDT
+    lct_header_len += 1;
+  }
+  if (include_fti) { // Add EXT_FTI
+    lct_header_len += 4;
   }
 
   auto max_packet_length = max_size +
@@ -222,19 +247,43 @@ LibFlute::AlcPacket::AlcPacket(uint16_t tsi, uint16_t toi, LibFlute::FecOti fec_
     hdr_ptr += 1;
     *((uint16_t*)hdr_ptr) = htons(fdt_instance_id & 0x0000FFFF);
     hdr_ptr += 2;
+  }
 
+  if (include_fti) {
     *((uint8_t*)hdr_ptr) = EXT_FTI;
     hdr_ptr += 1;
     *((uint8_t*)hdr_ptr) = 4; // HEL
     hdr_ptr += 1;
-    *((uint16_t*)hdr_ptr) = htons((_fec_oti.transfer_length & 0x00FF0000) >> 32);
-    hdr_ptr += 2;
-    *((uint32_t*)hdr_ptr) = htonl(_fec_oti.transfer_length & 0x0000FFFF);
-    hdr_ptr += 4;
-    hdr_ptr += 2; // reserved
-    *((uint16_t*)hdr_ptr) = htons(_fec_oti.encoding_symbol_length);
-    hdr_ptr += 2;
-    *((uint32_t*)hdr_ptr) = htonl(_fec_oti.max_source_block_length);
+    switch (_fec_oti.encoding_id) {
+      case FecScheme::CompactNoCode:
+        *((uint16_t*)hdr_ptr) = htons((_fec_oti.transfer_length >> 32) & 0xFFFF);
+        hdr_ptr += 2;
+        *((uint32_t*)hdr_ptr) = htonl(_fec_oti.transfer_length & 0xFFFFFFFF);
+        hdr_ptr += 4;
+        hdr_ptr += 2; // reserved
+        *((uint16_t*)hdr_ptr) = htons(_fec_oti.encoding_symbol_length);
+        hdr_ptr += 2;
+        *((uint32_t*)hdr_ptr) = htonl(_fec_oti.max_source_block_length);
+        break;
+      case FecScheme::Raptor:
+        if (_fec_oti.scheme_specific_info.length() != 4) {
+          throw "Missing scheme specific info for Raptor FEC";
+        }
+        *((uint8_t*)hdr_ptr) = (_fec_oti.transfer_length >> 32) & 0xFF;
+        hdr_ptr += 1;
+        {
+          uint32_t transfer_length_lo = htonl(_fec_oti.transfer_length & 0xFFFFFFFF); // unaligned
+          std::memcpy(hdr_ptr, &transfer_length_lo, 4);
+        }
+        hdr_ptr += 4;
+        hdr_ptr += 1; // reserved
+        *((uint16_t*)hdr_ptr) = htons(_fec_oti.encoding_symbol_length);
+        hdr_ptr += 2;
+        std::memcpy(hdr_ptr, _fec_oti.scheme_specific_info.data(), 4); // Z, N, Al
+        break;
+      default:
+        throw "Unsupported FEC scheme";
+    }
   }
 }
 
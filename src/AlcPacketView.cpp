@@ -0,0 +1,244 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "AlcPacketView.h"
+#include <netinet/in.h>      // for ntohl, ntohs
+#include <cstring>           // for memcpy
+
+namespace {
+  // RFC5651 5.1 - LCT Header Format, first two octets
+  constexpr uint8_t VERSION_SHIFT = 4;
+  constexpr uint8_t CCI_SHIFT = 2;
+  constexpr uint8_t CCI_MASK = 0x03;
+  constexpr uint8_t TSI_FLAG = 0x80;
+  constexpr uint8_t TOI_SHIFT = 5;
+  constexpr uint8_t TOI_MASK = 0x03;
+  constexpr uint8_t HALF_WORD_FLAG = 0x10;
+  constexpr uint8_t CLOSE_SESSION_FLAG = 0x02;
+  constexpr uint8_t CLOSE_OBJECT_FLAG = 0x01;
+
+  constexpr size_t FIXED_HEADER_LEN = 4;
+  constexpr size_t CCI_LEN = 4; // only C = 0 is supported
+
+  constexpr uint8_t EXT_FTI  =  64;
+  constexpr uint8_t EXT_FDT  = 192;
+  constexpr uint8_t EXT_CENC = 193;
+
+  inline auto read_u16(const char* ptr) -> uint16_t
+  {
+    uint16_t val;
+    std::memcpy(&val, ptr, sizeof(val));
+    return ntohs(val);
+  }
+
+  inline auto read_u32(const char* ptr) -> uint32_t
+  {
+    uint32_t val;
+    std::memcpy(&val, ptr, sizeof(val));
+    return ntohl(val);
+  }
+}
+
+auto LibFlute::AlcPacketView::status_string(Status status) -> const char*
+{
+  switch (status) {
+    case Status::Ok: return "OK";
+    case Status::TooShort: return "Packet too short";
+    case Status::UnsupportedVersion: return "Unsupported LCT version";
+    case Status::UnsupportedCci: return "Unsupported CCI field length";
+    case Status::TsiMissing: return "TSI field not present";
+    case Status::ToiMissing: return "TOI field not present";
+    case Status::ToiTooLong: return "TOI fields over 64 bits in length are not supported";
+    case Status::UnsupportedFecScheme: return "Only the Compact No-Code and Raptor FEC schemes are supported";
+    case Status::MalformedHeaderExtension: return "Malformed LCT header extension";
+    case Status::InvalidFti: return "Invalid length for EXT_FTI header extension";
+    case Status::UnsupportedFluteVersion: return "Only FLUTE version 1 is supported";
+  }
+  return "Unknown status";
+}
+
+auto LibFlute::AlcPacketView::peek_tsi(const char* data, size_t len, uint64_t& tsi) -> Status
+{
+  if (len < FIXED_HEADER_LEN + CCI_LEN) {
+    return Status::TooShort;
+  }
+  auto b0 = static_cast<uint8_t>(data[0]);
+  auto b1 = static_cast<uint8_t>(data[1]);
+  if ((b0 >> VERSION_SHIFT) != 1) {
+    return Status::UnsupportedVersion;
+  }
+  if (((b0 >> CCI_SHIFT) & CCI_MASK) != 0) {
+    return Status::UnsupportedCci;
+  }
+
+  const char* ptr = data + FIXED_HEADER_LEN + CCI_LEN;
+  size_t tsi_len = ((b1 & TSI_FLAG) ? 4 : 0) + ((b1 & HALF_WORD_FLAG) ? 2 : 0);
+  if (tsi_len == 0) {
+    return Status::TsiMissing;
+  }
+  if (len < FIXED_HEADER_LEN + CCI_LEN + tsi_len) {
+    return Status::TooShort;
+  }
+
+  tsi = 0;
+  auto tsi_shift = 0;
+  if (b1 & HALF_WORD_FLAG) {
+    tsi = read_u16(ptr);
+    tsi_shift = 16;
+    ptr += 2;
+  }
+  if (b1 & TSI_FLAG) {
+    tsi |= static_cast<uint64_t>(read_u32(ptr)) << tsi_shift;
+  }
+  return Status::Ok;
+}
+
+auto LibFlute::AlcPacketView::parse(const char* data, size_t len) -> Status
+{
+  auto status = peek_tsi(data, len, _tsi);
+  if (status != Status::Ok) {
+    return status;
+  }
+
+  _data = data;
+  _len = len;
+  _toi = 0;
+  _fdt_instance_id = 0;
+  _content_encoding = ContentEncoding::NONE;
+  _fti_offset = 0;
+  _fdt_offset = 0;
+
+  auto b1 = static_cast<uint8_t>(data[1]);
+  bool half_word = (b1 & HALF_WORD_FLAG) != 0;
+  uint8_t toi_flag = (b1 >> TOI_SHIFT) & TOI_MASK;
+  _close_session = (b1 & CLOSE_SESSION_FLAG) != 0;
+  _close_object = (b1 & CLOSE_OBJECT_FLAG) != 0;
+
+  if (!_close_session && !half_word && toi_flag == 0) {
+    return Status::ToiMissing;
+  }
+  if (toi_flag == 3 || (toi_flag == 2 && half_word)) {
+    return Status::ToiTooLong;
+  }
+
+  switch (static_cast<uint8_t>(data[3])) {
+    case 0: _fec_scheme = FecScheme::CompactNoCode; break;
+    case 1: _fec_scheme = FecScheme::Raptor; break;
+    default: return Status::UnsupportedFecScheme;
+  }
+
+  size_t tsi_len = ((b1 & TSI_FLAG) ? 4 : 0) + (half_word ? 2 : 0);
+  size_t toi_len = toi_flag * 4 + (half_word ? 2 : 0);
+  size_t fixed_len = FIXED_HEADER_LEN + CCI_LEN + tsi_len + toi_len;
+
+  _header_length = static_cast<size_t>(static_cast<uint8_t>(data[2])) * 4;
+  if (_header_length < fixed_len) {
+    return Status::MalformedHeaderExtension;
+  }
+  if (_header_length > len) {
+    return Status::TooShort;
+  }
+
+  const char* ptr = data + FIXED_HEADER_LEN + CCI_LEN + tsi_len;
+  auto toi_shift = 0;
+  if (half_word) {
+    _toi = read_u16(ptr);
+    toi_shift = 16;
+    ptr += 2;
+  }
+  if (toi_flag == 1) {
+    _toi |= static_cast<uint64_t>(read_u32(ptr)) << toi_shift;
+    ptr += 4;
+  } else if (toi_flag == 2) {
+    _toi = read_u32(ptr);
+    _toi |= static_cast<uint64_t>(read_u32(ptr + 4)) << 32;
+    ptr += 8;
+  }
+
+  // Header extensions
+  const char* end = data + _header_length;
+  while (ptr < end) {
+    auto het = static_cast<uint8_t>(*ptr);
+    size_t ext_len = 4;
+    if (het < 128) {
+      if (end - ptr < 2) {
+        return Status::MalformedHeaderExtension;
+      }
+      ext_len = static_cast<size_t>(static_cast<uint8_t>(ptr[1])) * 4;
+      if (ext_len == 0) {
+        return Status::MalformedHeaderExtension;
+      }
+    }
+    if (static_cast<size_t>(end - ptr) < ext_len) {
+      return Status::MalformedHeaderExtension;
+    }
+
+    switch (het) {
+      case EXT_FTI:
+        if (ext_len != 16) {
+          return Status::InvalidFti;
+        }
+        _fti_offset = ptr - data;
+        break;
+      case EXT_FDT:
+        if ((static_cast<uint8_t>(ptr[1]) >> 4) != 1) {
+          return Status::UnsupportedFluteVersion;
+        }
+        _fdt_offset = ptr - data;
+        _fdt_instance_id = (static_cast<uint8_t>(ptr[1]) & 0x0F) << 16;
+        _fdt_instance_id |= read_u16(ptr + 2);
+        break;
+      case EXT_CENC:
+        switch (static_cast<uint8_t>(ptr[1])) {
+          case 1: _content_encoding = ContentEncoding::ZLIB; break;
+          case 2: _content_encoding = ContentEncoding::DEFLATE; break;
+          case 3: _content_encoding = ContentEncoding::GZIP; break;
+          default: _content_encoding = ContentEncoding::NONE; break;
+        }
+        break;
+      default:
+        break; // ignored
+    }
+    ptr += ext_len;
+  }
+  return Status::Ok;
+}
+
+auto LibFlute::AlcPacketView::fec_oti() const -> FecOti
+{
+  FecOti oti{_fec_scheme, 0, 0, 0, {}};
+  if (_fti_offset == 0) {
+    return oti;
+  }
+
+  const char* ptr = _data + _fti_offset + 2; // skip HET and HEL
+  switch (_fec_scheme) {
+    case FecScheme::CompactNoCode:
+      oti.transfer_length = static_cast<uint64_t>(read_u16(ptr)) << 32;
+      oti.transfer_length |= read_u32(ptr + 2);
+      oti.encoding_symbol_length = read_u16(ptr + 8);
+      oti.max_source_block_length = read_u32(ptr + 10);
+      break;
+    case FecScheme::Raptor:
+      oti.transfer_length = static_cast<uint64_t>(static_cast<uint8_t>(*ptr)) << 32;
+      oti.transfer_length |= read_u32(ptr + 1);
+      oti.encoding_symbol_length = read_u16(ptr + 6);
+      oti.scheme_specific_info.assign(ptr + 8, 4); // Z, N, Al
+      break;
+    default:
+      break;
+  }
+  return oti;
+}
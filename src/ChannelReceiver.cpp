@@ -0,0 +1,36 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "ChannelReceiver.h"
+#include <stddef.h>                                                 // for size_t
+#include <utility>                                                  // for move
+
+LibFlute::ChannelReceiver::ChannelReceiver ( std::shared_ptr<MemoryChannel> channel, const std::string& address,
+    unsigned short port, uint64_t tsi)
+  : ReceiverBase(address, port, tsi)
+  , _channel(std::move(channel))
+{
+  set_clock(_channel->clock());
+  _channel->set_sink([this](char* data, size_t len) {
+      if (_running) {
+        handle_received_packet(data, len);
+      }
+  });
+}
+
+LibFlute::ChannelReceiver::~ChannelReceiver()
+{
+  _channel->set_sink(nullptr);
+}
@@ -0,0 +1,32 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "Clock.h"
+
+auto LibFlute::Clock::seconds_since_epoch() -> uint64_t
+{
+  return std::chrono::duration_cast<std::chrono::seconds>(system_now().time_since_epoch()).count();
+}
+
+auto LibFlute::Clock::system() -> std::shared_ptr<Clock>
+{
+  static auto clock = std::make_shared<SystemClock>();
+  return clock;
+}
+
+auto LibFlute::SystemClock::make_timer(boost::asio::io_service& io_service) -> std::unique_ptr<Timer>
+{
+  return std::make_unique<SteadyTimer>(io_service);
+}
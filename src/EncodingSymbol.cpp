@@ -23,10 +23,17 @@
 #include "spdlog/spdlog.h"  // for warn
 
 auto LibFlute::EncodingSymbol::from_payload(char* encoded_data, size_t data_len, const FecOti& fec_oti, ContentEncoding encoding) -> std::vector<EncodingSymbol> 
+{
+  std::vector<EncodingSymbol> symbols;
+  from_payload(encoded_data, data_len, fec_oti, encoding, symbols);
+  return symbols;
+}
+
+auto LibFlute::EncodingSymbol::from_payload(char* encoded_data, size_t data_len, const FecOti& fec_oti, ContentEncoding encoding, std::vector<EncodingSymbol>& symbols) -> void
 {
   auto source_block_number = 0;
   auto encoding_symbol_id = 0;
-  std::vector<EncodingSymbol> symbols;
+  symbols.clear();
 
   if (encoding != ContentEncoding::NONE) {
     throw "Only unencoded content is supported";
@@ -35,6 +42,9 @@ auto LibFlute::EncodingSymbol::from_payload(char* encoded_data, size_t data_len,
   switch (fec_oti.encoding_id) {
     case FecScheme::CompactNoCode:
     case FecScheme::Raptor:
+      if (data_len < 4) {
+        throw "Payload too short";
+      }
       source_block_number = ntohs(*(uint16_t*)encoded_data);
       encoded_data += 2;
       encoding_symbol_id = ntohs(*(uint16_t*)encoded_data);
@@ -58,8 +68,6 @@ auto LibFlute::EncodingSymbol::from_payload(char* encoded_data, size_t data_len,
     encoded_data += fec_oti.encoding_symbol_length;
     encoding_symbol_id++;
   }
-
-  return symbols;
 }
 
 auto LibFlute::EncodingSymbol::to_payload(const std::vector<EncodingSymbol>& symbols, char* encoded_data, size_t data_len, const FecOti& fec_oti) -> size_t
@@ -114,6 +114,7 @@ LibFlute::File::File(uint32_t toi,
       _meta.fec_oti.encoding_symbol_length = std::dynamic_pointer_cast<RaptorFEC>(_meta.fec_transformer)->T;
       _meta.fec_oti.max_source_block_length = std::dynamic_pointer_cast<RaptorFEC>(_meta.fec_transformer)->K * 
         std::dynamic_pointer_cast<RaptorFEC>(_meta.fec_transformer)->T;
+      _meta.fec_oti.scheme_specific_info = std::dynamic_pointer_cast<RaptorFEC>(_meta.fec_transformer)->scheme_specific_info();
       break;
 #endif
     default:
@@ -135,11 +136,11 @@ LibFlute::File::~File()
   }
 }
 
-auto LibFlute::File::put_symbol( const LibFlute::EncodingSymbol& symbol ) -> void
+auto LibFlute::File::put_symbol( const LibFlute::EncodingSymbol& symbol ) -> bool
 {
   if(_complete) {
     spdlog::debug("Not handling symbol {} , SBN {} since file is already complete",symbol.id(),symbol.source_block_number());
-    return;
+    return false;
   }
   if (symbol.source_block_number() > _source_blocks.size()) {
     throw "Source Block number too high";
@@ -148,8 +149,8 @@ auto LibFlute::File::put_symbol( const LibFlute::EncodingSymbol& symbol ) -> voi
   SourceBlock& source_block = _source_blocks[ symbol.source_block_number() ];
   
   if(source_block.complete){
-      spdlog::warn("Ignoring symbol {} since block {} is already complete",symbol.id(),symbol.source_block_number());
-	  return;
+      spdlog::debug("Ignoring symbol {} since block {} is already complete",symbol.id(),symbol.source_block_number());
+	  return false;
   }
 
   if (symbol.id() > source_block.symbols.size()) {
@@ -166,8 +167,9 @@ auto LibFlute::File::put_symbol( const LibFlute::EncodingSymbol& symbol ) -> voi
     }
     check_source_block_completion(source_block);
     check_file_completion();
+    return true;
   }
-
+  return false;
 }
 
 auto LibFlute::File::check_source_block_completion( SourceBlock& block ) -> void
@@ -183,10 +185,9 @@ auto LibFlute::File::check_file_completion() -> void
 {
   _complete = std::all_of(_source_blocks.begin(), _source_blocks.end(), [](const auto& block){ return block.second.complete; });
 
-  if (_complete && !_meta.content_md5.empty()) {
-      if(_meta.fec_transformer){
-          _meta.fec_transformer->extract_file(_source_blocks);
-      }
+  // Objects started from in-band FEC OTI have no MD5 until the FDT arrives, so don't depend on it here
+  if (_complete && _meta.fec_transformer) {
+      _meta.fec_transformer->extract_file(_source_blocks);
   }
 }
 
@@ -0,0 +1,77 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "LatencyHistogram.h"
+#include <algorithm>                                                // for min
+#include <cmath>                                                    // for ceil
+
+auto LibFlute::LatencyHistogram::bucket(uint64_t latency_ns) -> size_t
+{
+  if (latency_ns < sub_buckets) {
+    return latency_ns;
+  }
+  // the highest bit selects the power of two, the next bits the linear sub bucket
+  auto msb = static_cast<size_t>(63 - __builtin_clzll(latency_ns));
+  auto shift = msb - sub_bucket_bits;
+  return (shift + 1) * sub_buckets + ((latency_ns >> shift) & (sub_buckets - 1));
+}
+
+auto LibFlute::LatencyHistogram::bucket_limit(size_t bucket) -> uint64_t
+{
+  if (bucket < sub_buckets) {
+    return bucket + 1;
+  }
+  auto shift = bucket / sub_buckets - 1;
+  auto lower = (sub_buckets + bucket % sub_buckets) << shift;
+  return lower + (1ULL << shift);
+}
+
+auto LibFlute::LatencyHistogram::record(uint64_t latency_ns) -> void
+{
+  _buckets[bucket(latency_ns)].fetch_add(1, std::memory_order_relaxed);
+  if (latency_ns > _max_ns.load(std::memory_order_relaxed)) {
+    _max_ns.store(latency_ns, std::memory_order_relaxed);
+  }
+  _count.fetch_add(1, std::memory_order_relaxed);
+}
+
+auto LibFlute::LatencyHistogram::percentile(double fraction, uint64_t count) const -> uint64_t
+{
+  auto rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(count)));
+  auto max_ns = _max_ns.load(std::memory_order_relaxed);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < _buckets.size(); i++) {
+    seen += _buckets[i].load(std::memory_order_relaxed);
+    if (seen >= rank) {
+      return std::min(bucket_limit(i), max_ns);
+    }
+  }
+  return max_ns;
+}
+
+auto LibFlute::LatencyHistogram::statistics() const -> Statistics
+{
+  auto count = _count.load(std::memory_order_relaxed);
+  if (count == 0) {
+    return Statistics{0, 0, 0, 0, 0};
+  }
+  return Statistics{
+    count,
+    percentile(0.5, count),
+    percentile(0.99, count),
+    percentile(0.999, count),
+    _max_ns.load(std::memory_order_relaxed)
+  };
+}
@@ -0,0 +1,128 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "LivePcapReceiver.h"
+#include <stdexcept>                                                // for runtime_error
+#include <boost/system/error_code.hpp>
+#include "spdlog/spdlog.h"
+
+LibFlute::LivePcapReceiver::LivePcapReceiver ( const std::string& iface, const std::string& address,
+    unsigned short port, uint64_t tsi, boost::asio::io_service& io_service,
+    size_t buffer_size, bool promiscuous)
+  : ReceiverBase(address, port, tsi)
+  , _parser(address, port)
+  , _descriptor(io_service)
+{
+  char errbuf[PCAP_ERRBUF_SIZE];
+
+  _pcap = pcap_create(iface.c_str(), errbuf);
+  if (_pcap == nullptr) {
+    throw std::runtime_error("Can't open capture on " + iface + ": " + std::string(errbuf));
+  }
+
+  try {
+    // deliver packets as soon as they arrive instead of waiting for a full buffer block
+    if (pcap_set_snaplen(_pcap, 65535) != 0 ||
+        pcap_set_buffer_size(_pcap, static_cast<int>(buffer_size)) != 0 ||
+        pcap_set_immediate_mode(_pcap, 1) != 0 ||
+        pcap_set_promisc(_pcap, promiscuous ? 1 : 0) != 0) {
+      throw std::runtime_error("Can't configure capture on " + iface);
+    }
+
+    auto status = pcap_activate(_pcap);
+    if (status < 0) {
+      throw std::runtime_error("Can't start capture on " + iface + ": " + std::string(pcap_geterr(_pcap)));
+    } else if (status > 0) {
+      spdlog::warn("Capture on {}: {}", iface, pcap_geterr(_pcap));
+    }
+
+    _parser.attach(_pcap);
+
+    if (pcap_setnonblock(_pcap, 1, errbuf) != 0) {
+      throw std::runtime_error("Can't set capture on " + iface + " to non-blocking: " + std::string(errbuf));
+    }
+    auto fd = pcap_get_selectable_fd(_pcap);
+    if (fd < 0) {
+      throw std::runtime_error("Capture on " + iface + " has no selectable descriptor");
+    }
+    _descriptor.assign(fd);
+  } catch (...) {
+    pcap_close(_pcap);
+    throw;
+  }
+
+  spdlog::info("Capturing {}:{} on {} with a {} byte buffer", address, port, iface, buffer_size);
+  wait_readable();
+}
+
+LibFlute::LivePcapReceiver::~LivePcapReceiver()
+{
+  // the descriptor belongs to the capture handle
+  _descriptor.release();
+  pcap_close(_pcap);
+}
+
+auto LibFlute::LivePcapReceiver::statistics() -> Statistics
+{
+  struct pcap_stat stats = {};
+  if (pcap_stats(_pcap, &stats) != 0) {
+    return Statistics{_packets, 0, 0, 0};
+  }
+  return Statistics{_packets, stats.ps_recv, stats.ps_drop, stats.ps_ifdrop};
+}
+
+auto LibFlute::LivePcapReceiver::wait_readable() -> void
+{
+  _descriptor.async_wait(boost::asio::posix::stream_descriptor::wait_read,
+      [this](const boost::system::error_code& error) { handle_readable(error); });
+}
+
+auto LibFlute::LivePcapReceiver::handle_readable(const boost::system::error_code& error) -> void
+{
+  if (!_running || error == boost::asio::error::operation_aborted) {
+    return;
+  }
+  if (error) {
+    spdlog::error("capture error: {}", error.message());
+    return;
+  }
+
+  // drain the capture buffer in batches
+  int nof_packets = 0;
+  do {
+    nof_packets = pcap_dispatch(_pcap, max_packets_per_dispatch, &LivePcapReceiver::handle_frame,
+        reinterpret_cast<unsigned char*>(this)); //NOLINT
+    if (nof_packets < 0) {
+      spdlog::error("capture error: {}", pcap_geterr(_pcap));
+      return;
+    }
+  } while (nof_packets > 0 && _running);
+
+  if (_running) {
+    wait_readable();
+  }
+}
+
+auto LibFlute::LivePcapReceiver::handle_frame(unsigned char* user, const struct pcap_pkthdr* header,
+    const unsigned char* data) -> void
+{
+  auto* receiver = reinterpret_cast<LivePcapReceiver*>(user); //NOLINT
+  const unsigned char* payload = nullptr;
+  size_t payload_len = 0;
+  if (receiver->_parser.udp_payload(header, data, payload, payload_len)) {
+    receiver->_packets++;
+    receiver->handle_received_packet(const_cast<char*>(reinterpret_cast<const char*>(payload)), payload_len); //NOLINT
+  }
+}
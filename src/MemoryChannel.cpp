@@ -0,0 +1,183 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "MemoryChannel.h"
+#include <algorithm>                                                // for max, min
+#include <boost/system/error_code.hpp>
+#include <utility>                                                  // for move
+
+LibFlute::MemoryChannel::MemoryChannel(boost::asio::io_service& io_service)
+  : MemoryChannel(io_service, Impairments())
+{
+}
+
+LibFlute::MemoryChannel::MemoryChannel(boost::asio::io_service& io_service, const Impairments& impairments,
+    std::shared_ptr<Clock> clock)
+  : _io_service(io_service)
+  , _clock(clock ? std::move(clock) : Clock::system())
+  , _timer(_clock->make_timer(io_service))
+  , _impairments(impairments)
+  , _random(impairments.seed)
+{
+}
+
+auto LibFlute::MemoryChannel::set_sink(sink_t sink) -> void
+{
+  const std::lock_guard<std::mutex> lock(_mutex);
+  _sink = std::move(sink);
+}
+
+auto LibFlute::MemoryChannel::statistics() -> Statistics
+{
+  const std::lock_guard<std::mutex> lock(_mutex);
+  return _stats;
+}
+
+auto LibFlute::MemoryChannel::chance(double probability) -> bool
+{
+  // always draw, so the sequence of random numbers does not depend on the probabilities
+  return _uniform(_random) < probability;
+}
+
+auto LibFlute::MemoryChannel::lose_packet() -> bool
+{
+  if (_impairments.gilbert_p_good_bad <= 0) {
+    return chance(_impairments.loss);
+  }
+
+  if (_bad_state) {
+    _bad_state = !chance(_impairments.gilbert_p_bad_good);
+  } else {
+    _bad_state = chance(_impairments.gilbert_p_good_bad);
+  }
+  return chance(_bad_state ? _impairments.gilbert_loss_bad : _impairments.gilbert_loss_good);
+}
+
+auto LibFlute::MemoryChannel::async_send(const char* data, size_t len, send_handler_t handler) -> void
+{
+  {
+    const std::lock_guard<std::mutex> lock(_mutex);
+    auto now = _clock->now();
+    _stats.sent++;
+
+    // packets held back for reordering are released after the next reorder_distance packets
+    std::vector<std::vector<char>> released;
+    for (auto it = _held.begin(); it != _held.end();) {
+      if (--it->countdown == 0) {
+        released.push_back(std::move(it->data));
+        it = _held.erase(it);
+      } else {
+        ++it;
+      }
+    }
+
+    if (lose_packet()) {
+      _stats.lost++;
+    } else {
+      std::vector<char> packet(data, data + len);
+      auto duplicate = chance(_impairments.duplicate);
+      if (duplicate) {
+        _stats.duplicated++;
+        enqueue(packet, now);
+      }
+      if (chance(_impairments.reorder) && _impairments.reorder_distance > 0) {
+        _stats.reordered++;
+        _held.push_back(HeldPacket{_impairments.reorder_distance,
+            now + std::chrono::microseconds(_impairments.reorder_timeout_us), std::move(packet)});
+      } else {
+        enqueue(std::move(packet), now);
+      }
+    }
+
+    for (auto& packet : released) {
+      enqueue(std::move(packet), now);
+    }
+    schedule_delivery();
+  }
+
+  // the data has been copied, so the sender can continue right away
+  boost::asio::post(_io_service, [handler]() { handler(boost::system::error_code()); });
+}
+
+auto LibFlute::MemoryChannel::enqueue(std::vector<char> data, Clock::time_point now) -> void
+{
+  if (_impairments.queue_limit > 0 && _queue.size() >= _impairments.queue_limit) {
+    _stats.queue_dropped++;
+    return;
+  }
+
+  // serialize the packets on the link, then add the propagation delay
+  auto due = now;
+  if (_impairments.rate > 0) {
+    auto transmission_ns = static_cast<long>(data.size() * 8 * 1e9 / static_cast<double>(_impairments.rate));
+    _link_free = std::max(_link_free, now) + std::chrono::nanoseconds(transmission_ns);
+    due = _link_free;
+  }
+  due += std::chrono::microseconds(_impairments.delay_us);
+  _queue.push_back(QueuedPacket{due, std::move(data)});
+}
+
+auto LibFlute::MemoryChannel::schedule_delivery() -> void
+{
+  if (_queue.empty() && _held.empty()) {
+    return;
+  }
+
+  // held packets are released by the timer as well, in case the sender goes idle
+  auto due = _queue.empty() ? _held.front().release_at : _queue.front().due;
+  if (!_held.empty()) {
+    due = std::min(due, _held.front().release_at);
+  }
+  if (_delivery_scheduled && _scheduled_at <= due) {
+    return;
+  }
+  // setting an earlier expiry aborts the pending wait
+  _delivery_scheduled = true;
+  _scheduled_at = due;
+  _timer->expires_at(due);
+  _timer->async_wait([this](const boost::system::error_code& error) {
+      if (!error) {
+        deliver();
+      }
+  });
+}
+
+auto LibFlute::MemoryChannel::deliver() -> void
+{
+  std::vector<std::vector<char>> due_packets;
+  sink_t sink;
+  {
+    const std::lock_guard<std::mutex> lock(_mutex);
+    _delivery_scheduled = false;
+    auto now = _clock->now();
+    while (!_held.empty() && _held.front().release_at <= now) {
+      enqueue(std::move(_held.front().data), now);
+      _held.erase(_held.begin());
+    }
+    while (!_queue.empty() && _queue.front().due <= now) {
+      due_packets.push_back(std::move(_queue.front().data));
+      _queue.pop_front();
+    }
+    _stats.delivered += due_packets.size();
+    sink = _sink;
+    schedule_delivery();
+  }
+
+  if (sink) {
+    for (auto& packet : due_packets) {
+      sink(packet.data(), packet.size());
+    }
+  }
+}
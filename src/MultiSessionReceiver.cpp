@@ -0,0 +1,137 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "MultiSessionReceiver.h"
+#include <boost/bind/bind.hpp>
+#include <boost/system/error_code.hpp>
+#include "AlcPacketView.h"
+#include "spdlog/spdlog.h"
+
+
+LibFlute::MultiSessionReceiver::MultiSessionReceiver ( const std::string& iface, const std::string& address,
+    unsigned short port, boost::asio::io_service& io_service)
+  : _mcast_address(address)
+  , _mcast_port(port)
+  , _socket(io_service)
+{
+    boost::asio::ip::udp::endpoint listen_endpoint(
+        boost::asio::ip::address::from_string(iface), _mcast_port);
+    _socket.open(listen_endpoint.protocol());
+    _socket.set_option(boost::asio::ip::multicast::enable_loopback(true));
+    _socket.set_option(boost::asio::ip::udp::socket::reuse_address(true));
+    _socket.set_option(boost::asio::socket_base::receive_buffer_size(16*1024*1024));
+    _socket.bind(listen_endpoint);
+
+    // Join the multicast group.
+    _socket.set_option(
+        boost::asio::ip::multicast::join_group(
+          boost::asio::ip::address::from_string(_mcast_address)));
+
+    start_receive();
+}
+
+auto LibFlute::MultiSessionReceiver::add_session(uint64_t tsi) -> std::shared_ptr<ReceiverBase>
+{
+  const std::lock_guard<std::mutex> lock(_sessions_mutex);
+  auto it = _sessions.find(tsi);
+  if (it == _sessions.end()) {
+    spdlog::info("Adding session with TSI {}", tsi);
+    it = _sessions.emplace(tsi, std::make_shared<Session>(_mcast_address, _mcast_port, tsi)).first;
+  }
+  return it->second;
+}
+
+auto LibFlute::MultiSessionReceiver::remove_session(uint64_t tsi) -> void
+{
+  std::shared_ptr<Session> session;
+  {
+    const std::lock_guard<std::mutex> lock(_sessions_mutex);
+    auto it = _sessions.find(tsi);
+    if (it == _sessions.end()) {
+      return;
+    }
+    session = it->second;
+    _sessions.erase(it);
+  }
+  // a packet for this session may still be in progress on the receiving thread, it holds its own reference
+  session->stop();
+  spdlog::info("Removed session with TSI {}", tsi);
+}
+
+auto LibFlute::MultiSessionReceiver::session(uint64_t tsi) -> std::shared_ptr<ReceiverBase>
+{
+  const std::lock_guard<std::mutex> lock(_sessions_mutex);
+  auto it = _sessions.find(tsi);
+  return it == _sessions.end() ? nullptr : it->second;
+}
+
+auto LibFlute::MultiSessionReceiver::session_tsis() -> std::vector<uint64_t>
+{
+  const std::lock_guard<std::mutex> lock(_sessions_mutex);
+  std::vector<uint64_t> tsis;
+  tsis.reserve(_sessions.size());
+  for (const auto& session : _sessions) {
+    tsis.push_back(session.first);
+  }
+  return tsis;
+}
+
+auto LibFlute::MultiSessionReceiver::start_receive() -> void
+{
+  _socket.async_receive_from(
+      boost::asio::buffer(_buffer.data(), max_length), _sender_endpoint,
+      boost::bind(&LibFlute::MultiSessionReceiver::handle_receive_from, this, //NOLINT
+        boost::asio::placeholders::error,
+        boost::asio::placeholders::bytes_transferred));
+}
+
+auto LibFlute::MultiSessionReceiver::handle_receive_from(const boost::system::error_code& error,
+    size_t bytes_recvd) -> void
+{
+  if (!_running || error == boost::asio::error::operation_aborted) {
+    return;
+  }
+
+  if (!error)
+  {
+    uint64_t tsi = 0;
+    auto status = AlcPacketView::peek_tsi(_buffer.data(), bytes_recvd, tsi);
+    if (status != AlcPacketView::Status::Ok) {
+      spdlog::debug("Discarding packet: {}", AlcPacketView::status_string(status));
+    } else {
+      std::shared_ptr<Session> session;
+      {
+        const std::lock_guard<std::mutex> lock(_sessions_mutex);
+        auto it = _sessions.find(tsi);
+        if (it != _sessions.end()) {
+          session = it->second;
+        }
+      }
+
+      if (session) {
+        session->handle_packet(_buffer.data(), bytes_recvd);
+      } else {
+        _unknown_tsi_packets.fetch_add(1, std::memory_order_relaxed);
+        spdlog::trace("Discarding packet for unknown TSI {}", tsi);
+      }
+    }
+
+    start_receive();
+  }
+  else
+  {
+    spdlog::error("receive_from error: {}", error.message());
+  }
+}
@@ -0,0 +1,111 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "PacketRing.h"
+#include <cstring>                                                  // for memcpy
+
+LibFlute::PacketRing::PacketRing(size_t capacity, size_t slot_size)
+  : _slot_size(slot_size)
+{
+  if (capacity == 0 || slot_size == 0) {
+    throw "Invalid packet ring dimensions";
+  }
+  size_t slots = 1;
+  while (slots < capacity) {
+    slots <<= 1;
+  }
+  _mask = slots - 1;
+  _buffer.resize(slots * slot_size);
+  _lengths.resize(slots);
+}
+
+auto LibFlute::PacketRing::push(const char* data, size_t len) -> bool
+{
+  if (len > _slot_size) {
+    _oversized.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  auto tail = _tail.load(std::memory_order_relaxed);
+  auto head = _head.load(std::memory_order_acquire);
+  if (tail - head > _mask) {
+    _overflows.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  auto slot = tail & _mask;
+  memcpy(&_buffer[slot * _slot_size], data, len);
+  _lengths[slot] = len;
+  _tail.store(tail + 1, std::memory_order_seq_cst);
+
+  auto occupancy = tail + 1 - head;
+  if (occupancy > _high_watermark.load(std::memory_order_relaxed)) {
+    _high_watermark.store(occupancy, std::memory_order_relaxed);
+  }
+
+  // pairs with the store in wait(): either the consumer sees the new tail, or we see it waiting
+  if (_consumer_waiting.load(std::memory_order_seq_cst)) {
+    notify();
+  }
+  return true;
+}
+
+auto LibFlute::PacketRing::front(char*& data, size_t& len) -> bool
+{
+  auto head = _head.load(std::memory_order_relaxed);
+  if (head == _tail.load(std::memory_order_acquire)) {
+    return false;
+  }
+  auto slot = head & _mask;
+  data = &_buffer[slot * _slot_size];
+  len = _lengths[slot];
+  return true;
+}
+
+auto LibFlute::PacketRing::pop() -> void
+{
+  _head.store(_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+auto LibFlute::PacketRing::wait(std::chrono::milliseconds timeout) -> bool
+{
+  std::unique_lock<std::mutex> lock(_wait_mutex);
+  _consumer_waiting.store(true, std::memory_order_seq_cst);
+  if (_head.load(std::memory_order_relaxed) == _tail.load(std::memory_order_seq_cst)) {
+    _wait_cv.wait_for(lock, timeout);
+  }
+  _consumer_waiting.store(false, std::memory_order_relaxed);
+  return _head.load(std::memory_order_relaxed) != _tail.load(std::memory_order_acquire);
+}
+
+auto LibFlute::PacketRing::notify() -> void
+{
+  const std::lock_guard<std::mutex> lock(_wait_mutex);
+  _wait_cv.notify_one();
+}
+
+auto LibFlute::PacketRing::statistics() const -> Statistics
+{
+  auto head = _head.load(std::memory_order_acquire);
+  auto tail = _tail.load(std::memory_order_acquire);
+  return Statistics{
+    _mask + 1,
+    tail >= head ? tail - head : 0,
+    _high_watermark.load(std::memory_order_relaxed),
+    tail,
+    _overflows.load(std::memory_order_relaxed),
+    _oversized.load(std::memory_order_relaxed)
+  };
+}
@@ -0,0 +1,165 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "PcapParser.h"
+#include <arpa/inet.h>                                              // for inet_pton, ntohs
+#include <linux/if_ether.h>                                         // for ETH_HLEN, ETH_P_IP
+#include <netinet/in.h>                                             // for IPPROTO_UDP
+#include <netinet/ip.h>                                             // for ip, IP_MF, IP_OFFMASK
+#include <netinet/udp.h>                                            // for udphdr
+#include <sys/socket.h>                                             // for AF_INET
+#include <cstring>                                                  // for memcpy
+#include <stdexcept>                                                // for runtime_error
+#include "spdlog/spdlog.h"
+
+LibFlute::PcapParser::PcapParser(const std::string& address, unsigned short port)
+  : _address(address)
+  , _port(port)
+{
+  struct in_addr group = {};
+  if (inet_pton(AF_INET, address.c_str(), &group) != 1) {
+    throw std::runtime_error("Invalid IPv4 multicast address " + address);
+  }
+  _address_n = group.s_addr;
+}
+
+auto LibFlute::PcapParser::attach(pcap_t* pcap) -> void
+{
+  _link_type = pcap_datalink(pcap);
+  switch (_link_type) {
+    case DLT_RAW:
+#ifdef DLT_IPV4
+    case DLT_IPV4:
+#endif
+    case DLT_EN10MB:
+    case DLT_LINUX_SLL:
+#ifdef DLT_LINUX_SLL2
+    case DLT_LINUX_SLL2:
+#endif
+    case DLT_NULL:
+      break;
+    default:
+      throw std::runtime_error("Unsupported PCAP link type " + std::to_string(_link_type));
+  }
+
+  // Let libpcap drop everything that is not for our session, instead of parsing every packet here
+  auto session = "udp and dst host " + _address + " and dst port " + std::to_string(_port);
+  auto expression = session;
+  if (_link_type == DLT_EN10MB) {
+    expression = "(" + session + ") or (vlan and " + session + ") or (vlan and vlan and " + session + ")";
+  }
+  struct bpf_program filter = {};
+  if (pcap_compile(pcap, &filter, expression.c_str(), 1, PCAP_NETMASK_UNKNOWN) != 0) {
+    throw std::runtime_error("Can't compile PCAP filter: " + std::string(pcap_geterr(pcap)));
+  }
+  auto result = pcap_setfilter(pcap, &filter);
+  pcap_freecode(&filter);
+  if (result != 0) {
+    throw std::runtime_error("Can't set PCAP filter: " + std::string(pcap_geterr(pcap)));
+  }
+}
+
+auto LibFlute::PcapParser::ip_header_offset(const struct pcap_pkthdr* header, const unsigned char* data, size_t& offset) const -> bool
+{
+  constexpr uint16_t ETHERTYPE_VLAN = 0x8100;
+  constexpr uint16_t ETHERTYPE_QINQ = 0x88A8;
+  constexpr size_t SLL_HEADER_LEN = 16;
+  constexpr size_t NULL_HEADER_LEN = 4;
+
+  auto caplen = header->caplen;
+  auto read_u16 = [data](size_t at) -> uint16_t { return (data[at] << 8) | data[at + 1]; };
+
+  uint16_t protocol = ETH_P_IP;
+  switch (_link_type) {
+    case DLT_EN10MB:
+      offset = ETH_HLEN;
+      if (caplen < offset) {
+        return false;
+      }
+      protocol = read_u16(ETH_HLEN - 2);
+      while (protocol == ETHERTYPE_VLAN || protocol == ETHERTYPE_QINQ) {
+        offset += 4;
+        if (caplen < offset) {
+          return false;
+        }
+        protocol = read_u16(offset - 2);
+      }
+      break;
+    case DLT_LINUX_SLL:
+      offset = SLL_HEADER_LEN;
+      if (caplen < offset) {
+        return false;
+      }
+      protocol = read_u16(SLL_HEADER_LEN - 2);
+      break;
+#ifdef DLT_LINUX_SLL2
+    case DLT_LINUX_SLL2: {
+      constexpr size_t SLL2_HEADER_LEN = 20;
+      offset = SLL2_HEADER_LEN;
+      if (caplen < offset) {
+        return false;
+      }
+      protocol = read_u16(0);
+      break;
+    }
+#endif
+    case DLT_NULL: {
+      // address family in the byte order of the capturing host
+      offset = NULL_HEADER_LEN;
+      if (caplen < offset) {
+        return false;
+      }
+      uint32_t family = 0;
+      memcpy(&family, data, sizeof(family));
+      if (family != AF_INET && __builtin_bswap32(family) != AF_INET) {
+        return false;
+      }
+      break;
+    }
+    default:
+      offset = 0;
+      break;
+  }
+  return protocol == ETH_P_IP;
+}
+
+auto LibFlute::PcapParser::udp_payload(const struct pcap_pkthdr* header, const unsigned char* data,
+    const unsigned char*& payload, size_t& len) const -> bool
+{
+  size_t offset = 0;
+  if (!ip_header_offset(header, data, offset) || header->caplen < offset + sizeof(struct ip)) {
+    return false;
+  }
+  auto ip_header = reinterpret_cast<const struct ip*>(data + offset); //NOLINT
+  size_t ip_header_len = ip_header->ip_hl * 4;
+  if (ip_header->ip_v != 4 || ip_header_len < sizeof(struct ip) || ip_header->ip_p != IPPROTO_UDP ||
+      (ntohs(ip_header->ip_off) & (IP_MF | IP_OFFMASK)) != 0 ||
+      header->caplen < offset + ip_header_len + sizeof(struct udphdr)) {
+    return false;
+  }
+  auto udp_header = reinterpret_cast<const struct udphdr*>(data + offset + ip_header_len); //NOLINT
+  if (ip_header->ip_dst.s_addr != _address_n || ntohs(udp_header->uh_dport) != _port) {
+    return false;
+  }
+
+  size_t udp_len = ntohs(udp_header->uh_ulen);
+  if (udp_len < sizeof(struct udphdr) || offset + ip_header_len + udp_len > header->caplen) {
+    spdlog::debug("Discarding truncated UDP datagram");
+    return false;
+  }
+  payload = data + offset + ip_header_len + sizeof(struct udphdr);
+  len = udp_len - sizeof(struct udphdr);
+  return true;
+}
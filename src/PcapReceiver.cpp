@@ -14,6 +14,7 @@
 // under the License.
 //
 #include "PcapReceiver.h"
+#include <algorithm>                                                // for max
 #include <ctime>
 #include <boost/bind/bind.hpp>
 #include <boost/system/error_code.hpp>
@@ -21,7 +22,7 @@
 #include <exception>
 #include <string>
 #include <type_traits>
-#include <utility>                                                  // for pair
+#include <utility>                                                  // for pair, move
 #include "AlcPacket.h"
 #include "EncodingSymbol.h"
 #include "File.h"                                                   // for File
@@ -34,16 +35,18 @@
 
 
 LibFlute::PcapReceiver::PcapReceiver ( const std::string& pcap_file, const std::string& address,
-    unsigned short port, uint64_t tsi, boost::asio::io_service& io_service, unsigned skip_ms)
+    unsigned short port, uint64_t tsi, boost::asio::io_service& io_service, unsigned skip_ms,
+    std::shared_ptr<Clock> clock)
   : ReceiverBase(address, port, tsi)
-  , _packet_timer( io_service )
+  , _pcap_file_name(pcap_file)
+  , _parser(address, port)
+  , _io_service(io_service)
+  , _clock(clock ? std::move(clock) : Clock::system())
+  , _packet_timer(_clock->make_timer(io_service))
 {
-  char errbuf[PCAP_ERRBUF_SIZE];
+  set_clock(_clock);
 
-  _pcap_file = pcap_open_offline(pcap_file.c_str(), errbuf);
-  if (_pcap_file == nullptr) {
-    throw std::runtime_error("Can't open PCAP file: " + std::string(errbuf));
-  }
+  open_file();
 
   // Get the first packet to establish a time base
   read_packet();
@@ -53,37 +56,70 @@ LibFlute::PcapReceiver::PcapReceiver ( const std::string& pcap_file, const std::
     throw std::runtime_error("No packets found in file");
   }
 
-  // start processing the file
-  process_packet();
+  // start processing the file once the io_service runs, so the replay options can still be set
+  boost::asio::post(io_service, [this]() {
+      _start_time = _clock->now();
+      process_packet();
+  });
 }
 
 LibFlute::PcapReceiver::~PcapReceiver() {
-  if (_pcap_file == nullptr) {
+  if (_pcap_file != nullptr) {
     pcap_close(_pcap_file);
   }
 }
 
+auto LibFlute::PcapReceiver::open_file() -> void
+{
+  char errbuf[PCAP_ERRBUF_SIZE];
+
+  _pcap_file = pcap_open_offline(_pcap_file_name.c_str(), errbuf);
+  if (_pcap_file == nullptr) {
+    throw std::runtime_error("Can't open PCAP file: " + std::string(errbuf));
+  }
+
+  _parser.attach(_pcap_file);
+}
+
+auto LibFlute::PcapReceiver::statistics() const -> Statistics
+{
+  auto end = _finished ? _end_time : _clock->now();
+  std::chrono::duration<double> elapsed = end - _start_time;
+  return Statistics{_packets, _bytes, elapsed.count()};
+}
+
 auto LibFlute::PcapReceiver::process_packet() -> void
 {
   assert(_packet_data != nullptr);
+  if (!_running) {
+    return;
+  }
 
   // Check if the destination matches the mcast address and port we need and
-  // pass the payload on for FLUTE decoding if it does
-  check_packet();
-
-  // read the next packet
-  read_packet();
+  // pass the payload on for FLUTE decoding if it does. Then read the next packet.
+  unsigned batch = _speed > 0 ? 1 : max_packets_per_batch;
+  for (unsigned i = 0; i < batch && _packet_data != nullptr; i++) {
+    check_packet();
+    read_packet();
+  }
 
   if (_packet_data == nullptr) {
-    spdlog::info("Last packet processed, exiting.");
-  } else {
+    _end_time = _clock->now();
+    _finished = true;
+    auto stats = statistics();
+    spdlog::info("Last packet processed, exiting. {} packets, {} bytes in {:.3f} s: {:.0f} packets/s, {:.1f} Mbit/s",
+        stats.packets, stats.bytes, stats.seconds,
+        stats.packets / stats.seconds, stats.bytes * 8 / stats.seconds / 1e6);
+  } else if (_speed > 0) {
     // Calculate how long we have to wait until processing the next packet
     auto packet_time = tv_to_usecs(&_packet_header.ts);
-    auto delta = packet_time - _last_packet_time;
+    auto delta = std::max(packet_time - _last_packet_time, 0L);
     _last_packet_time = packet_time;
 
-    _packet_timer.expires_from_now(boost::posix_time::microseconds(delta));
-    _packet_timer.async_wait( boost::bind(&PcapReceiver::process_packet, this)); //NOLINT
+    _packet_timer->expires_after(std::chrono::microseconds(static_cast<long>(delta / _speed)));
+    _packet_timer->async_wait( boost::bind(&PcapReceiver::process_packet, this)); //NOLINT
+  } else {
+    boost::asio::post(_io_service, boost::bind(&PcapReceiver::process_packet, this)); //NOLINT
   }
 }
 
@@ -91,21 +127,34 @@ auto LibFlute::PcapReceiver::read_packet() -> void
 {
   assert(_pcap_file != nullptr);
   _packet_data = pcap_next(_pcap_file, &_packet_header);
+
+  if (_packet_data == nullptr && _loop + 1 < _loops) {
+    _loop++;
+    spdlog::debug("Replaying the capture again ({}/{})", _loop + 1, _loops);
+    pcap_close(_pcap_file);
+    _pcap_file = nullptr;
+    open_file();
+    reset_session();
+
+    _packet_data = pcap_next(_pcap_file, &_packet_header);
+    if (_packet_data != nullptr) {
+      _last_packet_time = tv_to_usecs(&_packet_header.ts);
+    }
+  }
 }
 
 auto LibFlute::PcapReceiver::check_packet() -> void
 {
   assert(_packet_data != nullptr);
 
-  auto ip_header = (struct ip*)(_packet_data);
-  auto udp_header = (struct udphdr*)(_packet_data + (ip_header->ip_hl * 4));
-
-  auto dest_address = std::string(inet_ntoa(ip_header->ip_dst));
-  auto dest_port = ntohs(udp_header->uh_dport);
-
-  if (dest_address == _mcast_address && dest_port == _mcast_port) {
-    auto payload = (_packet_data + (ip_header->ip_hl * 4) + sizeof(struct udphdr));
-    handle_received_packet((char*)payload, ntohs(udp_header->uh_ulen) - sizeof(struct udphdr));
+  // Check if the destination matches the mcast address and port we need and
+  // pass the payload on for FLUTE decoding if it does
+  const unsigned char* payload = nullptr;
+  size_t payload_len = 0;
+  if (_parser.udp_payload(&_packet_header, _packet_data, payload, payload_len)) {
+    _packets++;
+    _bytes += payload_len;
+    handle_received_packet((char*)payload, payload_len);
   }
 }
 
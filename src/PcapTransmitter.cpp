@@ -0,0 +1,174 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "PcapTransmitter.h"
+#include <sys/socket.h>                                             // for sendmmsg, mmsghdr
+#include <sys/uio.h>                                                // for iovec
+#include <algorithm>                                                // for max
+#include <cerrno>                                                   // for errno, EINTR
+#include <cstring>                                                  // for strerror
+#include <stdexcept>                                                // for runtime_error
+#include <pcap.h>                                                   // for pcap_open_offline, pcap_next
+#include "PcapParser.h"
+#include "spdlog/spdlog.h"
+
+LibFlute::PcapTransmitter::PcapTransmitter( const std::string& pcap_file, const std::string& address,
+    unsigned short port, boost::asio::io_service& io_service)
+  : _endpoint(boost::asio::ip::address::from_string(address), port)
+  , _socket(io_service, _endpoint.protocol())
+  , _timer(io_service)
+{
+  _socket.set_option(boost::asio::ip::multicast::enable_loopback(true));
+  _socket.set_option(boost::asio::ip::udp::socket::reuse_address(true));
+
+  load(pcap_file, address, port);
+  if (_packets.empty()) {
+    throw std::runtime_error("No packets for " + address + ":" + std::to_string(port) + " found in file");
+  }
+  spdlog::info("Loaded {} packets ({} bytes, {:.3f} s) from {}",
+      _packets.size(), _payloads.size(), _duration_us / 1e6, pcap_file);
+
+  // start sending once the io_service runs, so the replay options can still be set
+  boost::asio::post(io_service, [this]() {
+      _start_time = std::chrono::steady_clock::now();
+      send_next_batch();
+  });
+}
+
+auto LibFlute::PcapTransmitter::load(const std::string& pcap_file, const std::string& address,
+    unsigned short port) -> void
+{
+  char errbuf[PCAP_ERRBUF_SIZE];
+  auto* pcap = pcap_open_offline(pcap_file.c_str(), errbuf);
+  if (pcap == nullptr) {
+    throw std::runtime_error("Can't open PCAP file: " + std::string(errbuf));
+  }
+
+  try {
+    PcapParser parser(address, port);
+    parser.attach(pcap);
+
+    long first_time = 0;
+    struct pcap_pkthdr header = {};
+    const unsigned char* data = nullptr;
+    while ((data = pcap_next(pcap, &header)) != nullptr) {
+      const unsigned char* payload = nullptr;
+      size_t payload_len = 0;
+      if (!parser.udp_payload(&header, data, payload, payload_len)) {
+        continue;
+      }
+      long time = header.ts.tv_sec * 1'000'000 + header.ts.tv_usec;
+      if (_packets.empty()) {
+        first_time = time;
+      }
+      _packets.push_back(Packet{_payloads.size(), payload_len, std::max(time - first_time, 0L)});
+      _payloads.insert(_payloads.end(), payload, payload + payload_len);
+    }
+  } catch (...) {
+    pcap_close(pcap);
+    throw;
+  }
+  pcap_close(pcap);
+
+  if (!_packets.empty()) {
+    _duration_us = _packets.back().time_us;
+  }
+}
+
+auto LibFlute::PcapTransmitter::set_target(const std::string& address, unsigned short port) -> void
+{
+  boost::asio::ip::udp::endpoint endpoint(boost::asio::ip::address::from_string(address), port);
+  if (endpoint.protocol() != _endpoint.protocol()) {
+    throw std::runtime_error("Target address family must match the capture");
+  }
+  _endpoint = endpoint;
+}
+
+auto LibFlute::PcapTransmitter::statistics() const -> Statistics
+{
+  auto end = _finished ? _end_time : std::chrono::steady_clock::now();
+  std::chrono::duration<double> elapsed = end - _start_time;
+  return Statistics{_sent_packets, _sent_bytes, elapsed.count()};
+}
+
+auto LibFlute::PcapTransmitter::send_next_batch() -> void
+{
+  if (!_running) {
+    return;
+  }
+
+  // Collect the packets that are due (all of them, up to the batch size, when replaying as fast as
+  // possible), and send them with one system call
+  auto now = std::chrono::steady_clock::now();
+  auto due_time = [this](size_t index) {
+    auto time_us = static_cast<double>(_loop) * _duration_us + _packets[index].time_us;
+    return _start_time + std::chrono::microseconds(static_cast<long>(time_us / _speed));
+  };
+
+  struct mmsghdr messages[max_packets_per_batch] = {};
+  struct iovec iovecs[max_packets_per_batch];
+  unsigned nof_messages = 0;
+  while (nof_messages < max_packets_per_batch && _loop < _loops &&
+      (_speed <= 0 || due_time(_next) <= now)) {
+    auto& packet = _packets[_next];
+    iovecs[nof_messages].iov_base = &_payloads[packet.offset];
+    iovecs[nof_messages].iov_len = packet.len;
+    messages[nof_messages].msg_hdr.msg_name = _endpoint.data();
+    messages[nof_messages].msg_hdr.msg_namelen = static_cast<socklen_t>(_endpoint.size());
+    messages[nof_messages].msg_hdr.msg_iov = &iovecs[nof_messages];
+    messages[nof_messages].msg_hdr.msg_iovlen = 1;
+    nof_messages++;
+
+    if (++_next == _packets.size()) {
+      _next = 0;
+      _loop++;
+    }
+  }
+
+  unsigned sent = 0;
+  while (sent < nof_messages) {
+    auto result = sendmmsg(_socket.native_handle(), &messages[sent], nof_messages - sent, 0);
+    if (result < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      spdlog::error("sendmmsg failed: {}", strerror(errno));
+      break;
+    }
+    for (int i = 0; i < result; i++) {
+      _sent_bytes += messages[sent + i].msg_len;
+    }
+    sent += static_cast<unsigned>(result);
+  }
+  _sent_packets += sent;
+
+  if (_loop == _loops) {
+    _end_time = std::chrono::steady_clock::now();
+    _finished = true;
+    auto stats = statistics();
+    spdlog::info("Replay finished. {} packets, {} bytes in {:.3f} s: {:.0f} packets/s, {:.1f} Mbit/s",
+        stats.packets, stats.bytes, stats.seconds,
+        stats.packets / stats.seconds, stats.bytes * 8 / stats.seconds / 1e6);
+  } else if (_speed > 0) {
+    _timer.expires_at(due_time(_next));
+    _timer.async_wait([this](const boost::system::error_code& error) {
+        if (!error) {
+          send_next_batch();
+        }
+    });
+  } else {
+    boost::asio::post(_timer.get_executor(), [this]() { send_next_batch(); });
+  }
+}
@@ -0,0 +1,108 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "PcapWriter.h"
+#include <arpa/inet.h>                                              // for inet_pton, htons
+#include <netinet/in.h>                                             // for IPPROTO_UDP
+#include <netinet/ip.h>                                             // for ip, IPVERSION
+#include <netinet/udp.h>                                            // for udphdr
+#include <sys/socket.h>                                             // for AF_INET
+#include <cstring>                                                  // for memcpy
+#include <stdexcept>                                                // for runtime_error
+
+namespace {
+  auto parse_address(const std::string& address) -> uint32_t
+  {
+    struct in_addr addr = {};
+    if (inet_pton(AF_INET, address.c_str(), &addr) != 1) {
+      throw std::runtime_error("Invalid IPv4 address " + address);
+    }
+    return addr.s_addr;
+  }
+
+  auto ip_checksum(const unsigned char* header, size_t len) -> uint16_t
+  {
+    uint32_t sum = 0;
+    for (size_t i = 0; i + 1 < len; i += 2) {
+      sum += static_cast<uint32_t>(header[i] << 8U | header[i + 1]);
+    }
+    while ((sum >> 16U) != 0) {
+      sum = (sum & 0xffffU) + (sum >> 16U);
+    }
+    return htons(static_cast<uint16_t>(~sum));
+  }
+} // namespace
+
+LibFlute::PcapWriter::PcapWriter(const std::string& file_name, const std::string& source_address,
+    const std::string& address, unsigned short port)
+  : _source_n(parse_address(source_address))
+  , _address_n(parse_address(address))
+  , _port(port)
+{
+  _pcap = pcap_open_dead(DLT_RAW, 65535);
+  if (_pcap == nullptr) {
+    throw std::runtime_error("Can't create PCAP handle");
+  }
+  _dumper = pcap_dump_open(_pcap, file_name.c_str());
+  if (_dumper == nullptr) {
+    std::string error = pcap_geterr(_pcap);
+    pcap_close(_pcap);
+    throw std::runtime_error("Can't open PCAP file " + file_name + " for writing: " + error);
+  }
+}
+
+LibFlute::PcapWriter::~PcapWriter()
+{
+  pcap_dump_close(_dumper);
+  pcap_close(_pcap);
+}
+
+auto LibFlute::PcapWriter::write(const char* payload, size_t len, uint64_t timestamp_us) -> void
+{
+  const size_t headers_len = sizeof(struct ip) + sizeof(struct udphdr);
+  if (len > 65535 - headers_len) {
+    throw std::runtime_error("Packet too large for PCAP recording");
+  }
+  _buffer.resize(headers_len + len);
+
+  struct ip ip_header = {};
+  ip_header.ip_v = IPVERSION;
+  ip_header.ip_hl = sizeof(struct ip) / 4;
+  ip_header.ip_len = htons(static_cast<uint16_t>(headers_len + len));
+  ip_header.ip_id = htons(_ip_id++);
+  ip_header.ip_ttl = 64;
+  ip_header.ip_p = IPPROTO_UDP;
+  ip_header.ip_src.s_addr = _source_n;
+  ip_header.ip_dst.s_addr = _address_n;
+  memcpy(_buffer.data(), &ip_header, sizeof(ip_header));
+  ip_header.ip_sum = ip_checksum(_buffer.data(), sizeof(ip_header));
+  memcpy(_buffer.data(), &ip_header, sizeof(ip_header));
+
+  // the UDP checksum is optional for IPv4 and left at 0
+  struct udphdr udp_header = {};
+  udp_header.uh_sport = htons(_port);
+  udp_header.uh_dport = htons(_port);
+  udp_header.uh_ulen = htons(static_cast<uint16_t>(sizeof(struct udphdr) + len));
+  memcpy(_buffer.data() + sizeof(struct ip), &udp_header, sizeof(udp_header));
+  memcpy(_buffer.data() + headers_len, payload, len);
+
+  struct pcap_pkthdr header = {};
+  header.ts.tv_sec = static_cast<time_t>(timestamp_us / 1000000);
+  header.ts.tv_usec = static_cast<suseconds_t>(timestamp_us % 1000000);
+  header.caplen = static_cast<uint32_t>(_buffer.size());
+  header.len = header.caplen;
+  pcap_dump(reinterpret_cast<unsigned char*>(_dumper), &header, _buffer.data()); //NOLINT
+  _packets++;
+}
@@ -14,6 +14,15 @@
 // under the License.
 //
 #include "Receiver.h"
+#include <linux/sock_diag.h>                                        // for SK_MEMINFO_DROPS, SK_MEMINFO_VARS
+#include <netinet/udp.h>                                            // for SOL_UDP, UDP_GRO
+#include <pthread.h>                                                // for pthread_setaffinity_np
+#include <sched.h>                                                  // for cpu_set_t, CPU_SET
+#include <sys/socket.h>                                             // for recvmmsg, setsockopt
+#include <algorithm>                                                // for max, min
+#include <chrono>                                                   // for milliseconds
+#include <cerrno>                                                   // for errno
+#include <cstring>                                                  // for strerror
 #include <ctime>
 #include <boost/bind/bind.hpp>
 #include <boost/system/error_code.hpp>
@@ -26,13 +35,20 @@
 #include "EncodingSymbol.h"
 #include "File.h"                                                   // for File
 #include "IpSec.h"
+#include "SocketFilter.h"
 #include "flute_types.h"
 #include "spdlog/spdlog.h"
 
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#ifndef SO_PREFER_BUSY_POLL
+#define SO_PREFER_BUSY_POLL 69
+#endif
 
 
 LibFlute::Receiver::Receiver ( const std::string& iface, const std::string& address,
-    unsigned short port, uint64_t tsi, boost::asio::io_service& io_service)
+    unsigned short port, uint64_t tsi, boost::asio::io_service& io_service, bool reuse_port)
   : ReceiverBase(address, port, tsi)
   , _socket(io_service)
 {
@@ -41,7 +57,12 @@ LibFlute::Receiver::Receiver ( const std::string& iface, const std::string& addr
     _socket.open(listen_endpoint.protocol());
     _socket.set_option(boost::asio::ip::multicast::enable_loopback(true));
     _socket.set_option(boost::asio::ip::udp::socket::reuse_address(true));
+    if (reuse_port) {
+      _socket.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_REUSEPORT>(true));
+    }
     _socket.set_option(boost::asio::socket_base::receive_buffer_size(16*1024*1024));
+    // attach the count of datagrams dropped on a full receive buffer to the received ones, see ::metrics
+    _socket.set_option(boost::asio::detail::socket_option::boolean<SOL_SOCKET, SO_RXQ_OVFL>(true));
     _socket.bind(listen_endpoint);
 
     // Join the multicast group.
@@ -49,35 +70,343 @@ LibFlute::Receiver::Receiver ( const std::string& iface, const std::string& addr
         boost::asio::ip::multicast::join_group(
           boost::asio::ip::address::from_string(_mcast_address)));
 
+    start_receive();
+}
+
+LibFlute::Receiver::~Receiver()
+{
+  if (_poll_thread.joinable()) {
+    _running = false;
+    _poll_thread.join();
+  }
+  if (_decode_thread.joinable()) {
+    _decode_running = false;
+    _ring->notify();
+    _decode_thread.join();
+  }
+}
+
+auto LibFlute::Receiver::stop() -> void
+{
+  _running = false;
+  if (_decode_thread.joinable()) {
+    // may be called from the decode thread: abort the pending receive on the io_service thread, so run() can return
+    boost::asio::post(_socket.get_executor(), [this]() { _socket.cancel(); });
+  }
+}
+
+auto LibFlute::Receiver::enable_ipsec(uint32_t spi, const std::string& key) -> void 
+{
+  LibFlute::IpSec::enable_esp(spi, _mcast_address, LibFlute::IpSec::Direction::In, key);
+}
+
+auto LibFlute::Receiver::enable_batched_receive(unsigned batch_size) -> void
+{
+  _batch_size = std::max(batch_size, 1U);
+  setup_batch_buffers();
+  if (_batch_size > 1) {
+    spdlog::info("Batched receive enabled, reading up to {} datagrams per call", _batch_size);
+  }
+  restart_receive();
+}
+
+auto LibFlute::Receiver::enable_gro() -> bool
+{
+  if (_socket_filter_enabled) {
+    // The filter only sees the first datagram of a coalesced buffer
+    spdlog::warn("UDP GRO cannot be combined with a socket filter, receiving without it");
+    return false;
+  }
+  int enable = 1;
+  if (setsockopt(_socket.native_handle(), SOL_UDP, UDP_GRO, &enable, sizeof(enable)) != 0) {
+    spdlog::warn("UDP GRO is not available ({}), receiving without it", strerror(errno));
+    return false;
+  }
+  _gro_enabled = true;
+  setup_batch_buffers();
+  spdlog::info("UDP GRO enabled");
+  restart_receive();
+  return true;
+}
+
+auto LibFlute::Receiver::enable_socket_filter(uint64_t min_toi, uint64_t max_toi) -> bool
+{
+  if (_gro_enabled) {
+    // The filter only sees the first datagram of a coalesced buffer
+    spdlog::warn("A socket filter cannot be combined with UDP GRO, filtering in user space");
+    return false;
+  }
+  SocketFilter::Config config;
+  config.tsi = _tsi;
+  config.min_toi = min_toi;
+  config.max_toi = max_toi;
+  config.shard = _shard;
+  config.nof_shards = _nof_shards;
+  if (!SocketFilter::attach(_socket.native_handle(), SocketFilter::lct_filter(config))) {
+    spdlog::warn("Failed to attach socket filter ({}), filtering in user space", strerror(errno));
+    return false;
+  }
+  _socket_filter_enabled = true;
+  spdlog::info("Socket filter for TSI {} attached", _tsi);
+  return true;
+}
+
+auto LibFlute::Receiver::enable_decode_thread(size_t ring_size) -> void
+{
+  if (_decode_thread.joinable()) {
+    return;
+  }
+  _ring = std::make_unique<PacketRing>(ring_size, max_length);
+  _decode_running = true;
+  _decode_thread = std::thread(&LibFlute::Receiver::decode_loop, this);
+  spdlog::info("Decoding on a separate thread, ring size {}", ring_size);
+}
+
+auto LibFlute::Receiver::ring_statistics() const -> PacketRing::Statistics
+{
+  if (!_ring) {
+    return PacketRing::Statistics{0, 0, 0, 0, 0, 0};
+  }
+  return _ring->statistics();
+}
+
+auto LibFlute::Receiver::decode_loop() -> void
+{
+  char* data = nullptr;
+  size_t len = 0;
+  while (_decode_running) {
+    while (_ring->front(data, len)) {
+      handle_received_packet(data, len);
+      _ring->pop();
+    }
+    _ring->wait(std::chrono::milliseconds(100));
+  }
+}
+
+auto LibFlute::Receiver::enable_busy_poll(int cpu, unsigned busy_poll_us) -> bool
+{
+  if (_busy_poll) {
+    return true;
+  }
+
+  bool kernel_busy_poll = true;
+  int fd = _socket.native_handle();
+  int usecs = static_cast<int>(busy_poll_us);
+  int enable = 1;
+  if (setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs)) != 0) {
+    spdlog::warn("Kernel busy polling is not available ({}), spinning on the socket only", strerror(errno));
+    kernel_busy_poll = false;
+  } else if (setsockopt(fd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &enable, sizeof(enable)) != 0) {
+    spdlog::debug("SO_PREFER_BUSY_POLL is not supported ({})", strerror(errno));
+  }
+  if (setsockopt(fd, SOL_SOCKET, SO_TIMESTAMPNS, &enable, sizeof(enable)) != 0) {
+    spdlog::warn("Receive timestamps are not available ({}), latency is not recorded", strerror(errno));
+  }
+
+  // the polling thread takes over from the io_service, which is kept running until reception stops
+  _busy_poll = true;
+  setup_batch_buffers();
+  _socket.cancel();
+  _poll_work = std::make_unique<boost::asio::executor_work_guard<boost::asio::ip::udp::socket::executor_type>>(
+      _socket.get_executor());
+  _poll_thread = std::thread(&LibFlute::Receiver::poll_loop, this);
+
+  if (cpu >= 0) {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(cpu, &cpus);
+    if (pthread_setaffinity_np(_poll_thread.native_handle(), sizeof(cpus), &cpus) != 0) {
+      spdlog::warn("Failed to pin the polling thread to CPU {}", cpu);
+    }
+  }
+  spdlog::info("Busy poll receive enabled (CPU {}, {} us kernel busy polling)", cpu, kernel_busy_poll ? busy_poll_us : 0);
+  return kernel_busy_poll;
+}
+
+auto LibFlute::Receiver::poll_loop() -> void
+{
+  while (_running) {
+    if (receive_batch() < 0) {
+      break;
+    }
+  }
+  // lets io_service::run return
+  _poll_work.reset();
+}
+
+auto LibFlute::Receiver::dispatch_packet(char* data, size_t len) -> void
+{
+  if (!_ring) {
+    handle_received_packet(data, len);
+  } else if (!_ring->push(data, len)) {
+    spdlog::debug("Decode ring full, dropping packet");
+  }
+}
+
+auto LibFlute::Receiver::setup_batch_buffers() -> void
+{
+  if (_batch_size == 1 && !_gro_enabled && !_busy_poll) {
+    return;
+  }
+
+  // coalesced GRO buffers can be up to 64k, and carry the segment size in a control message
+  _batch_buffer_size = _gro_enabled ? max_gro_length : max_length;
+  size_t control_size = (_gro_enabled ? CMSG_SPACE(sizeof(int)) : 0) +
+    (_busy_poll ? CMSG_SPACE(sizeof(struct timespec)) : 0) +
+    CMSG_SPACE(sizeof(uint32_t)); // SO_RXQ_OVFL
+  _batch_control_size = control_size;
+
+  _batch_buffers.resize(_batch_size * _batch_buffer_size);
+  _batch_control.assign(_batch_size * control_size, 0);
+  _batch_iovecs.resize(_batch_size);
+  _batch_msgs.resize(_batch_size);
+  for (unsigned i = 0; i < _batch_size; i++) {
+    _batch_iovecs[i].iov_base = &_batch_buffers[i * _batch_buffer_size];
+    _batch_iovecs[i].iov_len = _batch_buffer_size;
+    _batch_msgs[i] = {};
+    _batch_msgs[i].msg_hdr.msg_iov = &_batch_iovecs[i];
+    _batch_msgs[i].msg_hdr.msg_iovlen = 1;
+    if (control_size > 0) {
+      _batch_msgs[i].msg_hdr.msg_control = &_batch_control[i * control_size];
+    }
+  }
+}
+
+auto LibFlute::Receiver::restart_receive() -> void
+{
+  // Abort the pending receive operation, it was started with the previous buffers
+  _socket.cancel();
+  start_receive();
+}
+
+auto LibFlute::Receiver::start_receive() -> void
+{
+  if (_busy_poll) {
+    return; // the polling thread receives
+  }
+  if (_batch_size > 1 || _gro_enabled) {
+    // wait for the socket to become readable, and then drain it with recvmmsg
+    _socket.async_wait(boost::asio::ip::udp::socket::wait_read,
+        boost::bind(&LibFlute::Receiver::handle_readable, this, //NOLINT
+          boost::asio::placeholders::error));
+  } else {
     _socket.async_receive_from(
         boost::asio::buffer(_buffer.data(), max_length), _sender_endpoint,
         boost::bind(&LibFlute::Receiver::handle_receive_from, this, //NOLINT
           boost::asio::placeholders::error,
           boost::asio::placeholders::bytes_transferred));
+  }
 }
 
-auto LibFlute::Receiver::enable_ipsec(uint32_t spi, const std::string& key) -> void 
+auto LibFlute::Receiver::handle_readable(const boost::system::error_code& error) -> void
 {
-  LibFlute::IpSec::enable_esp(spi, _mcast_address, LibFlute::IpSec::Direction::In, key);
+  if (!_running || error == boost::asio::error::operation_aborted) {
+    return;
+  }
+
+  if (error) {
+    spdlog::error("receive error: {}", error.message());
+    return;
+  }
+
+  if (receive_batch() < 0) {
+    return;
+  }
+
+  start_receive();
+}
+
+auto LibFlute::Receiver::receive_batch() -> int
+{
+  if (_batch_control_size > 0) {
+    // the kernel overwrites the control length with the length actually used
+    for (auto& msg : _batch_msgs) {
+      msg.msg_hdr.msg_controllen = _batch_control_size;
+    }
+  }
+
+  int nof_msgs = recvmmsg(_socket.native_handle(), _batch_msgs.data(), _batch_size, MSG_DONTWAIT, nullptr);
+  if (nof_msgs < 0) {
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+      spdlog::error("recvmmsg error: {}", strerror(errno));
+      return -1;
+    }
+    return 0;
+  }
+
+  spdlog::trace("Received {} datagrams", nof_msgs);
+  for (int i = 0; i < nof_msgs; i++) {
+    auto& hdr = _batch_msgs[i].msg_hdr;
+    if (hdr.msg_flags & MSG_TRUNC) {
+      spdlog::warn("Discarding truncated datagram");
+      continue;
+    }
+
+    auto* buffer = static_cast<char*>(_batch_iovecs[i].iov_base);
+    size_t length = _batch_msgs[i].msg_len;
+    size_t segment_size = length;
+    struct timespec received = {};
+    if (_batch_control_size > 0) {
+      for (auto* cmsg = CMSG_FIRSTHDR(&hdr); cmsg != nullptr; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+        if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+          int gso_size = 0;
+          memcpy(&gso_size, CMSG_DATA(cmsg), sizeof(gso_size));
+          if (gso_size > 0) {
+            segment_size = gso_size;
+          }
+        } else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS) {
+          memcpy(&received, CMSG_DATA(cmsg), sizeof(received));
+        } else if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL) {
+          uint32_t drops = 0;
+          memcpy(&drops, CMSG_DATA(cmsg), sizeof(drops));
+          _kernel_drops.set(drops);
+        }
+      }
+    }
+
+    // split coalesced buffers into the original datagrams, the last one may be shorter
+    for (size_t offset = 0; offset < length; offset += segment_size) {
+      dispatch_packet(buffer + offset, std::min(segment_size, length - offset));
+    }
+
+    if (received.tv_sec != 0) {
+      struct timespec now = {};
+      clock_gettime(CLOCK_REALTIME, &now);
+      auto latency_ns = (now.tv_sec - received.tv_sec) * 1000000000LL + (now.tv_nsec - received.tv_nsec);
+      _latency.record(latency_ns > 0 ? static_cast<uint64_t>(latency_ns) : 0);
+    }
+  }
+  return nof_msgs;
+}
+
+auto LibFlute::Receiver::metrics() -> Metrics
+{
+  auto metrics = ReceiverBase::metrics();
+  metrics.kernel_drops = _kernel_drops.value();
+
+  // the single datagram receive does not get control messages, read the same counter from the socket
+  uint32_t meminfo[SK_MEMINFO_VARS] = {};
+  socklen_t len = sizeof(meminfo);
+  if (getsockopt(_socket.native_handle(), SOL_SOCKET, SO_MEMINFO, meminfo, &len) == 0 &&
+      len > SK_MEMINFO_DROPS * sizeof(uint32_t)) {
+    metrics.kernel_drops = std::max<uint64_t>(metrics.kernel_drops, meminfo[SK_MEMINFO_DROPS]);
+  }
+  return metrics;
 }
 
 auto LibFlute::Receiver::handle_receive_from(const boost::system::error_code& error,
     size_t bytes_recvd) -> void
 {
-  if (!_running) {
+  if (!_running || error == boost::asio::error::operation_aborted) {
     return;
   }
 
   if (!error)
   {
     spdlog::trace("Received {} bytes", bytes_recvd);
-    handle_received_packet(_buffer.data(), bytes_recvd);
+    dispatch_packet(_buffer.data(), bytes_recvd);
 
-    _socket.async_receive_from(
-        boost::asio::buffer(_buffer.data(), max_length), _sender_endpoint,
-        boost::bind(&LibFlute::Receiver::handle_receive_from, this, //NOLINT
-          boost::asio::placeholders::error,
-          boost::asio::placeholders::bytes_transferred));
+    start_receive();
   }
   else 
   {
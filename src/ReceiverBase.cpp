@@ -14,6 +14,7 @@
 // under the License.
 //
 #include "ReceiverBase.h"
+#include <chrono>                                                   // for milliseconds
 #include <ctime>
 #include <boost/bind/bind.hpp>
 #include <boost/system/error_code.hpp>
@@ -22,12 +23,16 @@
 #include <string>
 #include <type_traits>
 #include <utility>                                                  // for pair
-#include "AlcPacket.h"
+#include "AlcPacketView.h"
 #include "EncodingSymbol.h"
 #include "File.h"                                                   // for File
 #include "IpSec.h"
 #include "flute_types.h"
+#include "fec/FecTransformer.h"
 #include "spdlog/spdlog.h"
+#ifdef RAPTOR_ENABLED
+#include "fec/RaptorFEC.h"
+#endif
 
 
 
@@ -42,42 +47,86 @@ LibFlute::ReceiverBase::ReceiverBase ( const std::string& address,
 
 auto LibFlute::ReceiverBase::handle_received_packet(char* data, size_t bytes) -> void
 {
-  spdlog::info("processing {} bytes", bytes);
-  try {
-    auto alc = LibFlute::AlcPacket(data, bytes);
+  spdlog::trace("processing {} bytes", bytes);
+  _counters_sequence.write_begin();
+  _counters.packets.add();
+  _counters.bytes.add(bytes);
+  _counters_sequence.write_end();
 
-    if (alc.tsi() != _tsi) {
-      spdlog::warn("Discarding packet for unknown TSI {}", alc.tsi());
-      return;
-    }
+  uint64_t tsi = 0;
+  auto status = LibFlute::AlcPacketView::peek_tsi(data, bytes, tsi);
+  if (status == LibFlute::AlcPacketView::Status::Ok && tsi != _tsi) {
+    spdlog::debug("Discarding packet for unknown TSI {}", tsi);
+    count(_counters.tsi_mismatches);
+    return;
+  }
+
+  LibFlute::AlcPacketView alc;
+  if (status == LibFlute::AlcPacketView::Status::Ok) {
+    status = alc.parse(data, bytes);
+  }
+  if (status != LibFlute::AlcPacketView::Status::Ok) {
+    spdlog::debug("Failed to decode ALC/FLUTE packet: {}", LibFlute::AlcPacketView::status_string(status));
+    count(_counters.parse_errors);
+    return;
+  }
 
-    const std::lock_guard<std::mutex> lock(_files_mutex);
+  if (!owns_toi(alc.toi())) {
+    return; // decoded by another shard
+  }
 
-    if (alc.toi() == 0 && (!_fdt || _fdt->instance_id() != alc.fdt_instance_id())) {
-      if (_files.find(alc.toi()) == _files.end()) {
-        FileDeliveryTable::FileEntry fe{0, "", static_cast<uint32_t>(alc.fec_oti().transfer_length), "", "", 0, alc.fec_oti(), nullptr};
-        _files.emplace(alc.toi(), std::make_shared<LibFlute::File>(fe));
+  std::unique_lock<std::mutex> lock(_files_mutex);
+  bool files_changed = false;
+  try {
+
+    // Only one lookup in the file table on the hot path, new objects are only created on a miss
+    auto file_it = _files.find(alc.toi());
+    if (file_it == _files.end()) {
+      if (alc.toi() == 0) {
+        // an expired instance ID may be reused, e.g. by a restarted transmitter
+        if (!_fdt || _fdt->instance_id() != alc.fdt_instance_id() ||
+            _fdt->expires() < _clock->seconds_since_epoch()) {
+          auto fec_oti = alc.fec_oti();
+          FileDeliveryTable::FileEntry fe{0, "", static_cast<uint32_t>(fec_oti.transfer_length), "", "", 0, fec_oti, nullptr};
+          file_it = _files.emplace(alc.toi(), create_file(fe)).first;
+          files_changed = true;
+        }
+      } else if (alc.has_fec_oti() && !already_delivered(alc.toi())) {
+        file_it = start_in_band_reception(alc);
+        files_changed = true;
       }
     }
 
-    if (_files.find(alc.toi()) != _files.end() && !_files[alc.toi()]->complete()) {
-      auto encoding_symbols = LibFlute::EncodingSymbol::from_payload(
+    if (file_it != _files.end() && !file_it->second->complete()) {
+      // keep a reference, the completion handling below may erase the table entry
+      std::shared_ptr<LibFlute::File> file = file_it->second;
+
+      // reuses the capacity of _symbols, no allocations once it has grown to the max. symbols per packet
+      LibFlute::EncodingSymbol::from_payload(
           data + alc.header_length(), 
-          bytes - alc.header_length(),
-          _files[alc.toi()]->fec_oti(),
-          alc.content_encoding());
+          alc.payload_length(),
+          file->fec_oti(),
+          alc.content_encoding(),
+          _symbols);
 
-      for (const auto& symbol : encoding_symbols) {
+      unsigned duplicates = 0;
+      for (const auto& symbol : _symbols) {
 
         spdlog::debug("received TOI {} SBN {} ID {}", alc.toi(), symbol.source_block_number(), symbol.id() );
-        _files[alc.toi()]->put_symbol(symbol);
+        if (!file->put_symbol(symbol)) {
+          duplicates++;
+        }
+      }
+      if (duplicates > 0) {
+        count(_counters.duplicate_symbols, duplicates);
       }
 
-      auto* file = _files[alc.toi()].get();
-      if (_files[alc.toi()]->complete()) {
+      if (file->complete()) {
+        files_changed = true;
         for (auto it = _files.begin(); it != _files.end();)
         {
-          if (it->second.get() != file && it->second->meta().content_location == file->meta().content_location)
+          if (it->second != file && !file->meta().content_location.empty() &&
+              it->second->meta().content_location == file->meta().content_location)
           {
             spdlog::debug("Replacing file with TOI {}", it->first);
             it = _files.erase(it);
@@ -89,22 +138,44 @@ auto LibFlute::ReceiverBase::handle_received_packet(char* data, size_t bytes) ->
         }
 
         spdlog::debug("File with TOI {} completed", alc.toi());
-        if (alc.toi() != 0 && _completion_cb) {
-          _completion_cb(_files[alc.toi()]);
-          _files.erase(alc.toi());
+        if (alc.toi() != 0) {
+          if (file->meta().content_location.empty()) {
+            spdlog::debug("Holding back TOI {} until its FDT entry has been received", alc.toi());
+          } else {
+            deliver_file(alc.toi());
+          }
         }
 
         if (alc.toi() == 0) { // parse complete FDT
           _fdt = std::make_unique<LibFlute::FileDeliveryTable>(
-              alc.fdt_instance_id(), _files[alc.toi()]->buffer(), _files[alc.toi()]->length());
+              alc.fdt_instance_id(), file->buffer(), file->length());
+          count(_counters.fdt_instances);
+          prune_completed_objects();
 
           _files.erase(alc.toi());
           for (const auto& file_entry : _fdt->file_entries()) {
-            // automatically receive all files in the FDT
-            if (_files.find(file_entry.toi) == _files.end()) {
+            if (!owns_toi(file_entry.toi)) {
+              continue;
+            }
+            auto existing = _files.find(file_entry.toi);
+            if (existing != _files.end()) {
+              if (existing->second->meta().content_location.empty()) {
+                // reception was started from in-band FEC OTI, fill in the metadata
+                auto& meta = existing->second->meta();
+                meta.content_location = file_entry.content_location;
+                meta.content_length = file_entry.content_length;
+                meta.content_md5 = file_entry.content_md5;
+                meta.content_type = file_entry.content_type;
+                meta.expires = file_entry.expires;
+                if (existing->second->complete()) {
+                  deliver_file(file_entry.toi);
+                }
+              }
+            } else if (!already_delivered(file_entry.toi)) {
+              // automatically receive all files in the FDT
               spdlog::debug("Starting reception for file with TOI {}: {} ({})", file_entry.toi,
                   file_entry.content_location, file_entry.content_type);
-              _files.emplace(file_entry.toi, std::make_shared<LibFlute::File>(file_entry));
+              _files.emplace(file_entry.toi, create_file(file_entry));
             }
           }
         }
@@ -114,11 +185,158 @@ auto LibFlute::ReceiverBase::handle_received_packet(char* data, size_t bytes) ->
     }
   } catch (std::exception& ex) {
     spdlog::warn("Failed to decode ALC/FLUTE packet: {}", ex.what());
+    count(_counters.parse_errors);
+  } catch (const char* ex) {
+    spdlog::warn("Failed to decode ALC/FLUTE packet: {}", ex);
+    count(_counters.parse_errors);
+  }
+  if (files_changed) {
+    update_bytes_buffered();
+  }
+
+  // Notify about completed files without holding the lock, so slow consumers do not stall reception
+  if (!_completed_files.empty()) {
+    std::vector<std::shared_ptr<LibFlute::File>> completed;
+    completed.swap(_completed_files);
+    lock.unlock();
+    dispatch_completions(completed);
+  }
+}
+
+auto LibFlute::ReceiverBase::start_in_band_reception(const AlcPacketView& alc) -> std::map<uint64_t, std::shared_ptr<LibFlute::File>>::iterator
+{
+  std::shared_ptr<FecTransformer> fec_transformer = nullptr;
+  switch (alc.fec_scheme()) {
+#ifdef RAPTOR_ENABLED
+    case FecScheme::Raptor:
+      fec_transformer = std::make_shared<RaptorFEC>();
+      break;
+#endif
+    case FecScheme::CompactNoCode:
+      break;
+    default:
+      spdlog::debug("In-band FEC OTI for TOI {} uses an unsupported FEC scheme", alc.toi());
+      return _files.end();
+  }
+  auto fec_oti = alc.fec_oti();
+  if (fec_oti.transfer_length == 0 || fec_oti.encoding_symbol_length == 0) {
+    spdlog::debug("Ignoring invalid in-band FEC OTI for TOI {}", alc.toi());
+    return _files.end();
+  }
+  if (fec_transformer && !fec_transformer->parse_fec_oti(fec_oti)) {
+    throw "Failed to parse in-band FEC OTI";
+  }
+
+  spdlog::debug("Starting reception for file with TOI {} from in-band FEC OTI", alc.toi());
+  FileDeliveryTable::FileEntry fe{static_cast<uint32_t>(alc.toi()), "", static_cast<uint32_t>(fec_oti.transfer_length), 
+    "", "", 0, fec_oti, fec_transformer};
+  return _files.emplace(alc.toi(), create_file(fe)).first;
+}
+
+auto LibFlute::ReceiverBase::create_file(const FileDeliveryTable::FileEntry& entry) -> std::shared_ptr<LibFlute::File>
+{
+  auto file = std::make_shared<LibFlute::File>(entry);
+  file->set_received_at(_clock->seconds_since_epoch());
+  return file;
+}
+
+auto LibFlute::ReceiverBase::deliver_file(uint64_t toi) -> void
+{
+  count(_counters.completed_objects);
+  if (_completion_cb || _max_queued_files > 0) {
+    auto file = _files[toi];
+    _completed_files.push_back(file);
+    _files.erase(toi);
+    _completed_objects[toi] = {file->meta().content_location, file->meta().content_md5, file->meta().expires};
+  }
+}
+
+auto LibFlute::ReceiverBase::already_delivered(uint64_t toi) -> bool
+{
+  auto it = _completed_objects.find(toi);
+  if (it == _completed_objects.end()) {
+    return false;
+  }
+  if (it->second.expires != 0 && it->second.expires < _clock->seconds_since_epoch()) {
+    spdlog::debug("Delivered object with TOI {} has expired, receiving it again", toi);
+    _completed_objects.erase(it);
+    return false;
+  }
+  return true;
+}
+
+auto LibFlute::ReceiverBase::prune_completed_objects() -> void
+{
+  // Keep only the TOIs that the new FDT instance still lists for the same object. Anything else
+  // has left the carousel, or the TOI has been reused (transmitter restart, wrap around).
+  std::map<uint64_t, CompletedObject> current;
+  for (const auto& file_entry : _fdt->file_entries()) {
+    auto it = _completed_objects.find(file_entry.toi);
+    if (it != _completed_objects.end() &&
+        it->second.content_location == file_entry.content_location &&
+        it->second.content_md5 == file_entry.content_md5) {
+      current.insert(*it);
+    }
+  }
+  _completed_objects.swap(current);
+}
+
+auto LibFlute::ReceiverBase::dispatch_completions(std::vector<std::shared_ptr<LibFlute::File>>& files) -> void
+{
+  for (const auto& file : files) {
+    if (_completion_cb) {
+      if (_completion_executor) {
+        boost::asio::post(*_completion_executor, [cb = _completion_cb, file]() { cb(file); });
+      } else {
+        _completion_cb(file);
+      }
+    }
+
+    if (_max_queued_files > 0) {
+      const std::lock_guard<std::mutex> lock(_completion_queue_mutex);
+      if (_completion_queue.size() >= _max_queued_files) {
+        spdlog::warn("Completion queue full, dropping {}", _completion_queue.front()->meta().content_location);
+        _completion_queue.pop_front();
+      }
+      _completion_queue.push_back(file);
+      _completion_queue_cv.notify_one();
+    }
+  }
+}
+
+auto LibFlute::ReceiverBase::enable_completion_queue(size_t max_files) -> void
+{
+  const std::lock_guard<std::mutex> lock(_completion_queue_mutex);
+  _max_queued_files = max_files;
+}
+
+auto LibFlute::ReceiverBase::next_completed(unsigned timeout_ms) -> std::shared_ptr<LibFlute::File>
+{
+  std::unique_lock<std::mutex> lock(_completion_queue_mutex);
+  if (_completion_queue.empty() && timeout_ms > 0) {
+    _completion_queue_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms), 
+        [this]() { return !_completion_queue.empty(); });
+  }
+  if (_completion_queue.empty()) {
+    return nullptr;
   }
+  auto file = _completion_queue.front();
+  _completion_queue.pop_front();
+  return file;
+}
+
+auto LibFlute::ReceiverBase::set_toi_shard(unsigned shard, unsigned nof_shards) -> void
+{
+  if (nof_shards == 0 || shard >= nof_shards) {
+    throw "Invalid TOI shard";
+  }
+  _shard = shard;
+  _nof_shards = nof_shards;
 }
 
 auto LibFlute::ReceiverBase::file_list() -> std::vector<std::shared_ptr<LibFlute::File>>
 {
+  const std::lock_guard<std::mutex> lock(_files_mutex);
   std::vector<std::shared_ptr<LibFlute::File>> files;
   for (auto& f : _files) {
     files.push_back(f.second);
@@ -126,18 +344,66 @@ auto LibFlute::ReceiverBase::file_list() -> std::vector<std::shared_ptr<LibFlute
   return files;
 }
 
+auto LibFlute::ReceiverBase::reset_session() -> void
+{
+  const std::lock_guard<std::mutex> lock(_files_mutex);
+  _files.clear();
+  _completed_objects.clear();
+  _fdt.reset();
+  update_bytes_buffered();
+}
+
+auto LibFlute::ReceiverBase::count(Counter& counter, uint64_t value) -> void
+{
+  _counters_sequence.write_begin();
+  counter.add(value);
+  _counters_sequence.write_end();
+}
+
+auto LibFlute::ReceiverBase::update_bytes_buffered() -> void
+{
+  uint64_t bytes = 0;
+  for (const auto& file : _files) {
+    bytes += file.second->length();
+  }
+  _bytes_buffered.set(bytes);
+}
+
+auto LibFlute::ReceiverBase::metrics() -> Metrics
+{
+  Metrics metrics = {};
+  uint64_t sequence = 0;
+  do {
+    sequence = _counters_sequence.read_begin();
+    metrics.packets = _counters.packets.value();
+    metrics.bytes = _counters.bytes.value();
+    metrics.tsi_mismatches = _counters.tsi_mismatches.value();
+    metrics.parse_errors = _counters.parse_errors.value();
+    metrics.duplicate_symbols = _counters.duplicate_symbols.value();
+    metrics.fdt_instances = _counters.fdt_instances.value();
+    metrics.completed_objects = _counters.completed_objects.value();
+  } while (_counters_sequence.read_retry(sequence));
+  metrics.expired_objects = _expired_objects.value();
+  metrics.bytes_buffered = _bytes_buffered.value();
+  return metrics;
+}
+
 auto LibFlute::ReceiverBase::remove_expired_files(unsigned max_age) -> void
 {
   const std::lock_guard<std::mutex> lock(_files_mutex);
   for (auto it = _files.cbegin(); it != _files.cend();)
   {
-    auto age = time(nullptr) - it->second->received_at();
+    auto age = _clock->seconds_since_epoch() - it->second->received_at();
     if ( it->second->meta().content_location != "bootstrap.multipart"  && age > max_age) {
+      if (!it->second->complete()) {
+        _expired_objects.add();
+      }
       it = _files.erase(it);
     } else {
       ++it;
     }
   }
+  update_bytes_buffered();
 }
 
 auto LibFlute::ReceiverBase::remove_file_with_content_location(const std::string& cl) -> void
@@ -151,4 +417,5 @@ auto LibFlute::ReceiverBase::remove_file_with_content_location(const std::string
       ++it;
     }
   }
+  update_bytes_buffered();
 }
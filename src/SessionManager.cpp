@@ -0,0 +1,158 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "SessionManager.h"
+#include <sys/socket.h>                                             // for recv
+#include <cerrno>                                                   // for errno
+#include <cstring>                                                  // for strerror
+#include <boost/system/error_code.hpp>
+#include "spdlog/spdlog.h"
+
+
+LibFlute::SessionManager::SessionManager ( const std::string& iface, boost::asio::io_service& io_service,
+    size_t receive_buffer_size)
+  : _io_service(io_service)
+  , _iface(boost::asio::ip::address::from_string(iface))
+  , _receive_buffer_size(receive_buffer_size)
+{
+}
+
+LibFlute::SessionManager::~SessionManager()
+{
+  const std::lock_guard<std::mutex> lock(_sessions_mutex);
+  for (auto& session : _sessions) {
+    session.second->stop();
+    boost::system::error_code ec;
+    session.second->socket.close(ec);
+  }
+}
+
+auto LibFlute::SessionManager::join(const std::string& address, unsigned short port, uint64_t tsi) -> std::shared_ptr<ReceiverBase>
+{
+  const std::lock_guard<std::mutex> lock(_sessions_mutex);
+  auto key = std::make_pair(address, port);
+  auto it = _sessions.find(key);
+  if (it != _sessions.end()) {
+    return it->second;
+  }
+
+  auto session = std::make_shared<Session>(address, port, tsi, _io_service);
+  auto group = boost::asio::ip::address::from_string(address);
+
+  // bind to the group address, so the socket only receives the packets of this group
+  boost::asio::ip::udp::endpoint listen_endpoint(group, port);
+  session->socket.open(listen_endpoint.protocol());
+  session->socket.set_option(boost::asio::ip::multicast::enable_loopback(true));
+  session->socket.set_option(boost::asio::ip::udp::socket::reuse_address(true));
+  if (_receive_buffer_size > 0) {
+    session->socket.set_option(boost::asio::socket_base::receive_buffer_size(static_cast<int>(_receive_buffer_size)));
+  }
+  session->socket.non_blocking(true);
+  session->socket.bind(listen_endpoint);
+  if (_iface.is_v4() && group.is_v4()) {
+    session->socket.set_option(boost::asio::ip::multicast::join_group(group.to_v4(), _iface.to_v4()));
+  } else {
+    session->socket.set_option(boost::asio::ip::multicast::join_group(group));
+  }
+
+  _sessions.emplace(key, session);
+  spdlog::debug("Joined {}:{} for TSI {}", address, port, tsi);
+
+  // socket operations must be started on the io_service thread. The destructor stops all sessions,
+  // so a stopped session means the manager may be gone: do not touch this then.
+  boost::asio::post(_io_service, [this, session]() {
+      if (session->running) {
+        wait_readable(session);
+      }
+  });
+  return session;
+}
+
+auto LibFlute::SessionManager::leave(const std::string& address, unsigned short port) -> void
+{
+  std::shared_ptr<Session> session;
+  {
+    const std::lock_guard<std::mutex> lock(_sessions_mutex);
+    auto it = _sessions.find(std::make_pair(address, port));
+    if (it == _sessions.end()) {
+      return;
+    }
+    session = it->second;
+    _sessions.erase(it);
+  }
+
+  session->stop();
+  // closing the socket leaves the group and aborts the pending wait, which releases the last reference
+  boost::asio::post(_io_service, [session]() {
+    boost::system::error_code ec;
+    session->socket.close(ec);
+  });
+  spdlog::debug("Left {}:{}", address, port);
+}
+
+auto LibFlute::SessionManager::session(const std::string& address, unsigned short port) -> std::shared_ptr<ReceiverBase>
+{
+  const std::lock_guard<std::mutex> lock(_sessions_mutex);
+  auto it = _sessions.find(std::make_pair(address, port));
+  return it == _sessions.end() ? nullptr : it->second;
+}
+
+auto LibFlute::SessionManager::nof_sessions() -> size_t
+{
+  const std::lock_guard<std::mutex> lock(_sessions_mutex);
+  return _sessions.size();
+}
+
+auto LibFlute::SessionManager::wait_readable(const std::shared_ptr<Session>& session) -> void
+{
+  if (!session->running || !session->socket.is_open()) {
+    return;
+  }
+  session->socket.async_wait(boost::asio::ip::udp::socket::wait_read,
+      [this, session](const boost::system::error_code& error) {
+        // aborted waits may complete after the manager has been destroyed, see ::join
+        if (error != boost::asio::error::operation_aborted && session->running) {
+          handle_readable(session, error);
+        }
+      });
+}
+
+auto LibFlute::SessionManager::handle_readable(const std::shared_ptr<Session>& session,
+    const boost::system::error_code& error) -> void
+{
+  if (error == boost::asio::error::operation_aborted || !session->running) {
+    return;
+  }
+  if (error) {
+    spdlog::error("receive error: {}", error.message());
+    return;
+  }
+
+  // drain the socket, but give other sessions a chance if it never runs dry
+  auto fd = session->socket.native_handle();
+  for (unsigned i = 0; i < max_packets_per_wakeup; i++) {
+    auto len = recv(fd, _buffer.data(), max_length, MSG_DONTWAIT);
+    if (len < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        spdlog::error("recv error: {}", strerror(errno));
+      }
+      break;
+    }
+    _packets.fetch_add(1, std::memory_order_relaxed);
+    session->handle_packet(_buffer.data(), static_cast<size_t>(len));
+  }
+
+  wait_readable(session);
+}
@@ -0,0 +1,151 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "ShardedReceiver.h"
+#include <exception>                                                // for exception
+#include "File.h"                                                   // for File
+#include "spdlog/spdlog.h"
+
+
+LibFlute::ShardedReceiver::ShardedReceiver ( const std::string& iface, const std::string& address,
+    unsigned short port, uint64_t tsi, unsigned nof_workers)
+{
+  if (nof_workers == 0) {
+    throw "At least one worker is required";
+  }
+
+  _workers.resize(nof_workers);
+  for (unsigned i = 0; i < nof_workers; i++) {
+    auto& worker = _workers[i];
+    worker.io = std::make_unique<boost::asio::io_service>();
+    worker.receiver = std::make_unique<LibFlute::Receiver>(iface, address, port, tsi, *worker.io,
+        true); // all workers bind the same port
+    worker.receiver->set_toi_shard(i, nof_workers);
+  }
+  spdlog::info("Sharded receiver with {} workers set up", nof_workers);
+}
+
+LibFlute::ShardedReceiver::~ShardedReceiver()
+{
+  stop();
+  wait();
+}
+
+auto LibFlute::ShardedReceiver::enable_ipsec(uint32_t spi, const std::string& key) -> void
+{
+  // the security association applies to the group, not to the sockets
+  _workers.front().receiver->enable_ipsec(spi, key);
+}
+
+auto LibFlute::ShardedReceiver::enable_batched_receive(unsigned batch_size) -> void
+{
+  for (auto& worker : _workers) {
+    worker.receiver->enable_batched_receive(batch_size);
+  }
+}
+
+auto LibFlute::ShardedReceiver::enable_gro() -> bool
+{
+  bool enabled = true;
+  for (auto& worker : _workers) {
+    enabled = worker.receiver->enable_gro() && enabled;
+  }
+  return enabled;
+}
+
+auto LibFlute::ShardedReceiver::enable_socket_filter() -> bool
+{
+  bool enabled = true;
+  for (auto& worker : _workers) {
+    enabled = worker.receiver->enable_socket_filter() && enabled;
+  }
+  return enabled;
+}
+
+auto LibFlute::ShardedReceiver::register_completion_callback(ReceiverBase::completion_callback_t cb) -> void
+{
+  for (auto& worker : _workers) {
+    worker.receiver->register_completion_callback(cb);
+  }
+}
+
+auto LibFlute::ShardedReceiver::file_list() -> std::vector<std::shared_ptr<LibFlute::File>>
+{
+  std::vector<std::shared_ptr<LibFlute::File>> files;
+  for (auto& worker : _workers) {
+    auto worker_files = worker.receiver->file_list();
+    files.insert(files.end(), worker_files.begin(), worker_files.end());
+  }
+  return files;
+}
+
+auto LibFlute::ShardedReceiver::metrics() -> std::vector<ReceiverBase::Metrics>
+{
+  std::vector<ReceiverBase::Metrics> metrics;
+  for (auto& worker : _workers) {
+    metrics.push_back(worker.receiver->metrics());
+  }
+  return metrics;
+}
+
+auto LibFlute::ShardedReceiver::remove_expired_files(unsigned max_age) -> void
+{
+  for (auto& worker : _workers) {
+    worker.receiver->remove_expired_files(max_age);
+  }
+}
+
+auto LibFlute::ShardedReceiver::remove_file_with_content_location(const std::string& cl) -> void
+{
+  for (auto& worker : _workers) {
+    worker.receiver->remove_file_with_content_location(cl);
+  }
+}
+
+auto LibFlute::ShardedReceiver::start() -> void
+{
+  for (unsigned i = 0; i < _workers.size(); i++) {
+    auto& worker = _workers[i];
+    if (worker.thread.joinable()) {
+      continue;
+    }
+    worker.thread = std::thread([&worker, i]() {
+      try {
+        worker.io->run();
+      } catch (std::exception& ex) {
+        spdlog::error("Worker {} exiting on unhandled exception: {}", i, ex.what());
+      } catch (const char* ex) {
+        spdlog::error("Worker {} exiting on unhandled exception: {}", i, ex);
+      }
+    });
+  }
+}
+
+auto LibFlute::ShardedReceiver::stop() -> void
+{
+  for (auto& worker : _workers) {
+    worker.receiver->stop();
+    worker.io->stop();
+  }
+}
+
+auto LibFlute::ShardedReceiver::wait() -> void
+{
+  for (auto& worker : _workers) {
+    if (worker.thread.joinable()) {
+      worker.thread.join();
+    }
+  }
+}
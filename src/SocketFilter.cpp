@@ -0,0 +1,197 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "SocketFilter.h"
+#include <netinet/in.h>                                             // for IPPROTO_UDP
+#include <sys/socket.h>                                             // for setsockopt, SO_ATTACH_FILTER
+#include <map>                                                      // for map
+
+namespace {
+  // Offsets as seen by a UDP socket filter: the UDP header precedes the payload
+  constexpr uint32_t UDP_HEADER_LEN = 8;
+  constexpr uint32_t LCT_FLAGS_0 = UDP_HEADER_LEN;     // V, C, PSI
+  constexpr uint32_t LCT_FLAGS_1 = UDP_HEADER_LEN + 1; // S, O, H, A, B
+  constexpr uint32_t LCT_TSI = UDP_HEADER_LEN + 8;     // after the fixed header and a 32 bit CCI
+
+  constexpr uint32_t VERSION_CCI_MASK = 0xFC;
+  constexpr uint32_t VERSION_1_CCI_0 = 0x10;
+  constexpr uint32_t TSI_FLAGS_MASK = 0x90;            // S and H
+  constexpr uint32_t TOI_FLAGS_MASK = 0x70;            // O and H
+  constexpr uint32_t S_FLAG = 0x80;
+  constexpr uint32_t H_FLAG = 0x10;
+  constexpr uint32_t O_32BIT = 0x20;
+
+  constexpr uint32_t ACCEPT = 0xFFFFFFFF;
+  constexpr uint32_t DROP = 0;
+
+  enum Label { NEXT = -1, L_ACCEPT, L_DROP, L_TSI_16, L_TSI_48, L_TOI };
+
+  // Classic BPF only has relative forward jumps. Instructions refer to labels, which are resolved at the end.
+  class ProgramBuilder {
+    public:
+      void stmt(uint16_t code, uint32_t k) { _insns.push_back({BPF_STMT(code, k), NEXT, NEXT}); };
+      void jump(uint16_t code, uint32_t k, int jt, int jf) { _insns.push_back({BPF_JUMP(code, k, 0, 0), jt, jf}); };
+      void label(Label l) { _labels[l] = _insns.size(); };
+
+      auto build() -> std::vector<struct sock_filter>
+      {
+        std::vector<struct sock_filter> program;
+        for (size_t i = 0; i < _insns.size(); i++) {
+          auto insn = _insns[i].insn;
+          insn.jt = offset(i, _insns[i].jt);
+          insn.jf = offset(i, _insns[i].jf);
+          program.push_back(insn);
+        }
+        return program;
+      };
+
+    private:
+      auto offset(size_t from, int target) -> uint8_t
+      {
+        if (target == NEXT) {
+          return 0;
+        }
+        auto distance = _labels.at(target) - from - 1;
+        if (distance > 255) {
+          throw "Socket filter jump out of range";
+        }
+        return static_cast<uint8_t>(distance);
+      };
+
+      struct Insn {
+        struct sock_filter insn;
+        int jt;
+        int jf;
+      };
+      std::vector<Insn> _insns;
+      std::map<int, size_t> _labels;
+  };
+
+  constexpr uint64_t MAX_U16 = 0xFFFF;
+  constexpr uint64_t MAX_U32 = 0xFFFFFFFF;
+}
+
+auto LibFlute::SocketFilter::lct_filter(const Config& config) -> std::vector<struct sock_filter>
+{
+  bool filter_toi = config.min_toi > 0 || config.max_toi < MAX_U32 || config.nof_shards > 1;
+  int tsi_match = filter_toi ? L_TOI : L_ACCEPT;
+
+  ProgramBuilder p;
+  // LCT version 1 with a 32 bit CCI, as supported by AlcPacketView
+  p.stmt(BPF_LD | BPF_B | BPF_ABS, LCT_FLAGS_0);
+  p.stmt(BPF_ALU | BPF_AND | BPF_K, VERSION_CCI_MASK);
+  p.jump(BPF_JMP | BPF_JEQ | BPF_K, VERSION_1_CCI_0, NEXT, L_DROP);
+
+  // TSI field length
+  p.stmt(BPF_LD | BPF_B | BPF_ABS, LCT_FLAGS_1);
+  p.stmt(BPF_ALU | BPF_AND | BPF_K, TSI_FLAGS_MASK);
+  p.jump(BPF_JMP | BPF_JEQ | BPF_K, H_FLAG, L_TSI_16, NEXT);
+  p.jump(BPF_JMP | BPF_JEQ | BPF_K, S_FLAG | H_FLAG, L_TSI_48, NEXT);
+  p.jump(BPF_JMP | BPF_JEQ | BPF_K, S_FLAG, NEXT, L_DROP);
+
+  // 32 bit TSI
+  if (config.tsi <= MAX_U32) {
+    p.stmt(BPF_LD | BPF_W | BPF_ABS, LCT_TSI);
+    p.jump(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(config.tsi), tsi_match, L_DROP);
+  } else {
+    p.stmt(BPF_RET | BPF_K, DROP);
+  }
+
+  // 16 bit TSI
+  p.label(L_TSI_16);
+  if (config.tsi <= MAX_U16) {
+    p.stmt(BPF_LD | BPF_H | BPF_ABS, LCT_TSI);
+    p.jump(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(config.tsi), tsi_match, L_DROP);
+  } else {
+    p.stmt(BPF_RET | BPF_K, DROP);
+  }
+
+  // 48 bit TSI: the half word holds the low 16 bits, followed by the upper 32 bits (as in AlcPacketView)
+  p.label(L_TSI_48);
+  p.stmt(BPF_LD | BPF_H | BPF_ABS, LCT_TSI);
+  p.jump(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>(config.tsi & MAX_U16), NEXT, L_DROP);
+  p.stmt(BPF_LD | BPF_W | BPF_ABS, LCT_TSI + 2);
+  p.jump(BPF_JMP | BPF_JEQ | BPF_K, static_cast<uint32_t>((config.tsi >> 16) & MAX_U32), tsi_match, L_DROP);
+
+  if (filter_toi) {
+    // only 32 bit TOIs following a 32 bit TSI are checked
+    p.label(L_TOI);
+    p.stmt(BPF_LD | BPF_B | BPF_ABS, LCT_FLAGS_1);
+    p.stmt(BPF_ALU | BPF_AND | BPF_K, TSI_FLAGS_MASK | TOI_FLAGS_MASK);
+    p.jump(BPF_JMP | BPF_JEQ | BPF_K, S_FLAG | O_32BIT, NEXT, L_ACCEPT);
+    p.stmt(BPF_LD | BPF_W | BPF_ABS, LCT_TSI + 4);
+    p.jump(BPF_JMP | BPF_JEQ | BPF_K, 0, L_ACCEPT, NEXT);  // FDT
+    if (config.min_toi > MAX_U32) {
+      p.stmt(BPF_RET | BPF_K, DROP);
+    } else if (config.min_toi > 0) {
+      p.jump(BPF_JMP | BPF_JGE | BPF_K, static_cast<uint32_t>(config.min_toi), NEXT, L_DROP);
+    }
+    if (config.max_toi < MAX_U32) {
+      p.jump(BPF_JMP | BPF_JGT | BPF_K, static_cast<uint32_t>(config.max_toi), L_DROP, NEXT);
+    }
+    if (config.nof_shards > 1) {
+      p.stmt(BPF_ALU | BPF_MOD | BPF_K, config.nof_shards);
+      p.jump(BPF_JMP | BPF_JEQ | BPF_K, config.shard, L_ACCEPT, L_DROP);
+    }
+  }
+
+  p.label(L_ACCEPT);
+  p.stmt(BPF_RET | BPF_K, ACCEPT);
+  p.label(L_DROP);
+  p.stmt(BPF_RET | BPF_K, DROP);
+  return p.build();
+}
+
+auto LibFlute::SocketFilter::ip_udp_filter(uint32_t address, uint16_t port) -> std::vector<struct sock_filter>
+{
+  // offsets in the IPv4 header
+  constexpr uint32_t IP_FRAGMENT = 6;
+  constexpr uint32_t IP_PROTOCOL = 9;
+  constexpr uint32_t IP_DESTINATION = 16;
+  constexpr uint32_t FRAGMENT_OFFSET_MASK = 0x1FFF;
+  constexpr uint32_t UDP_DESTINATION_PORT = 2;
+
+  ProgramBuilder p;
+  p.stmt(BPF_LD | BPF_W | BPF_ABS, IP_DESTINATION);
+  p.jump(BPF_JMP | BPF_JEQ | BPF_K, address, NEXT, L_DROP);
+  p.stmt(BPF_LD | BPF_B | BPF_ABS, IP_PROTOCOL);
+  p.jump(BPF_JMP | BPF_JEQ | BPF_K, IPPROTO_UDP, NEXT, L_DROP);
+  // only the first fragment carries the UDP header
+  p.stmt(BPF_LD | BPF_H | BPF_ABS, IP_FRAGMENT);
+  p.jump(BPF_JMP | BPF_JSET | BPF_K, FRAGMENT_OFFSET_MASK, L_DROP, NEXT);
+  p.stmt(BPF_LDX | BPF_B | BPF_MSH, 0); // X = IP header length
+  p.stmt(BPF_LD | BPF_H | BPF_IND, UDP_DESTINATION_PORT);
+  p.jump(BPF_JMP | BPF_JEQ | BPF_K, port, L_ACCEPT, L_DROP);
+
+  p.label(L_ACCEPT);
+  p.stmt(BPF_RET | BPF_K, ACCEPT);
+  p.label(L_DROP);
+  p.stmt(BPF_RET | BPF_K, DROP);
+  return p.build();
+}
+
+auto LibFlute::SocketFilter::drop_all_filter() -> std::vector<struct sock_filter>
+{
+  return { BPF_STMT(BPF_RET | BPF_K, DROP) };
+}
+
+auto LibFlute::SocketFilter::attach(int fd, const std::vector<struct sock_filter>& filter) -> bool
+{
+  struct sock_fprog program = {
+    static_cast<unsigned short>(filter.size()),
+    const_cast<struct sock_filter*>(filter.data()) //NOLINT
+  };
+  return setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program)) == 0;
+}
@@ -16,30 +16,33 @@
 #include "Transmitter.h"
 #include <cmath>                                                   // for ceil
 #include <boost/bind/bind.hpp>
-#include <boost/date_time/posix_time/posix_time_duration.hpp>
 #include <boost/system/error_code.hpp>
 #include <chrono>
 #include <cstdint>
 #include <cstdio>
 #include <exception>
 #include <new>
+#include <stdexcept>                                                // for runtime_error
 #include <string>
-#include <utility>                                                  // for pair
+#include <utility>                                                  // for pair, move
 #include <vector>
 #include "AlcPacket.h"
 #include "EncodingSymbol.h"
 #include "File.h"                                                   // for File
 #include "FileDeliveryTable.h"
 #include "IpSec.h"
+#include "PcapWriter.h"
+#include "Transport.h"
 #include "spdlog/spdlog.h"
 
 LibFlute::Transmitter::Transmitter ( const std::string& address, short port,
     uint64_t tsi, unsigned short mtu, uint32_t rate_limit, FecScheme fec_scheme,
-    boost::asio::io_service& io_service)
+    boost::asio::io_service& io_service, std::shared_ptr<Clock> clock)
   : _endpoint(boost::asio::ip::address::from_string(address), port)
   , _socket(io_service, _endpoint.protocol())
-  , _fdt_timer(io_service)
-  , _send_timer(io_service)
+  , _clock(clock ? std::move(clock) : Clock::system())
+  , _fdt_timer(_clock->make_timer(io_service))
+  , _send_timer(_clock->make_timer(io_service))
   , _io_service(io_service)
   , _tsi(tsi)
   , _mtu(mtu)
@@ -70,8 +73,8 @@ LibFlute::Transmitter::Transmitter ( const std::string& address, short port,
   _fec_oti = FecOti{_fec_scheme, 0, _max_payload, max_source_block_length};
   _fdt = std::make_unique<FileDeliveryTable>(1, _fec_oti);
 
-  _fdt_timer.expires_from_now(boost::posix_time::seconds(_fdt_repeat_interval));
-  _fdt_timer.async_wait( boost::bind(&Transmitter::fdt_send_tick, this)); //NOLINT
+  _fdt_timer->expires_after(std::chrono::seconds(_fdt_repeat_interval));
+  _fdt_timer->async_wait( boost::bind(&Transmitter::fdt_send_tick, this)); //NOLINT
 
   send_next_packet();
 }
@@ -83,6 +86,19 @@ auto LibFlute::Transmitter::enable_ipsec(uint32_t spi, const std::string& key) -
   LibFlute::IpSec::enable_esp(spi, _mcast_address, LibFlute::IpSec::Direction::Out, key);
 }
 
+auto LibFlute::Transmitter::enable_pcap_recording(const std::string& file_name, bool record_only,
+    const std::string& source_address) -> void
+{
+  if (!_endpoint.address().is_v4()) {
+    throw std::runtime_error("PCAP recording is only supported for IPv4 targets");
+  }
+  _pcap_writer = std::make_unique<PcapWriter>(file_name, source_address, _mcast_address, _endpoint.port());
+  _record_only = record_only;
+  _record_time_us = std::chrono::duration_cast<std::chrono::microseconds>(
+      _clock->system_now().time_since_epoch()).count();
+  spdlog::info("Recording packets to {}{}", file_name, record_only ? ", not sending to the network" : "");
+}
+
 auto LibFlute::Transmitter::seconds_since_epoch() -> uint64_t 
 {
   return std::chrono::duration_cast<std::chrono::seconds>(
@@ -90,7 +106,7 @@ auto LibFlute::Transmitter::seconds_since_epoch() -> uint64_t
 }
 
 auto LibFlute::Transmitter::send_fdt() -> void {
-  _fdt->set_expires(seconds_since_epoch() + static_cast<unsigned long>(_fdt_repeat_interval) * 2);
+  _fdt->set_expires(_clock->seconds_since_epoch() + static_cast<unsigned long>(_fdt_repeat_interval) * 2);
   auto fdt = _fdt->to_string();
   auto fdt_fec_oti = _fec_oti;
   fdt_fec_oti.encoding_id = FecScheme::CompactNoCode; // always send the FDT in "plaintext"
@@ -105,7 +121,7 @@ auto LibFlute::Transmitter::send_fdt() -> void {
       fdt_fec_oti,
       "",
       "",
-      seconds_since_epoch() + static_cast<unsigned long>(_fdt_repeat_interval) * 2,
+      _clock->seconds_since_epoch() + static_cast<unsigned long>(_fdt_repeat_interval) * 2,
       (char*)fdt.c_str(),
       fdt.length(),
       true);
@@ -153,8 +169,8 @@ auto LibFlute::Transmitter::send(
 auto LibFlute::Transmitter::fdt_send_tick() -> void
 {
   send_fdt();
-  _fdt_timer.expires_from_now(boost::posix_time::seconds(_fdt_repeat_interval));
-  _fdt_timer.async_wait( boost::bind(&Transmitter::fdt_send_tick, this)); //NOLINT
+  _fdt_timer->expires_after(std::chrono::seconds(_fdt_repeat_interval));
+  _fdt_timer->async_wait( boost::bind(&Transmitter::fdt_send_tick, this)); //NOLINT
 }
 
 auto LibFlute::Transmitter::file_transmitted(uint32_t toi) -> void
@@ -170,10 +186,36 @@ auto LibFlute::Transmitter::file_transmitted(uint32_t toi) -> void
   }
 }
 
+auto LibFlute::Transmitter::metrics() const -> Metrics
+{
+  Metrics metrics = {};
+  metrics.tsi = _tsi;
+  uint64_t queued = 0;
+  uint64_t sequence = 0;
+  do {
+    sequence = _counters_sequence.read_begin();
+    queued = _counters.queued.value();
+    metrics.packets = _counters.packets.value();
+    metrics.bytes = _counters.bytes.value();
+    metrics.send_errors = _counters.send_errors.value();
+    metrics.files_queued = _counters.files_queued.value();
+  } while (_counters_sequence.read_retry(sequence));
+  metrics.packets_in_flight = queued - metrics.packets - metrics.send_errors;
+  metrics.pacing_lag = _pacing_lag.statistics();
+  return metrics;
+}
+
 auto LibFlute::Transmitter::send_next_packet() -> void
 {
   uint32_t bytes_queued = 0;
 
+  if (_next_send_time != Clock::time_point()) {
+    // woken up by the rate limiter
+    auto lag = std::chrono::duration_cast<std::chrono::nanoseconds>(_clock->now() - _next_send_time).count();
+    _pacing_lag.record(lag > 0 ? static_cast<uint64_t>(lag) : 0);
+    _next_send_time = Clock::time_point();
+  }
+
   if (!_files.empty()) {
     for (auto& file_m : _files) {
       auto file = file_m.second;
@@ -185,33 +227,87 @@ auto LibFlute::Transmitter::send_next_packet() -> void
           for(const auto& symbol : symbols) {
             spdlog::debug("sending TOI {} SBN {} ID {}", file->meta().toi, symbol.source_block_number(), symbol.id() );
           }
-          auto packet = std::make_shared<AlcPacket>(_tsi, file->meta().toi, file->meta().fec_oti, symbols, _max_payload, file->fdt_instance_id());
+          auto packet = std::make_shared<AlcPacket>(_tsi, file->meta().toi, file->meta().fec_oti, symbols, _max_payload, file->fdt_instance_id(), _in_band_fti);
           bytes_queued += packet->size();
           spdlog::debug("Queued ALC packet of {} bytes, containing {} symbols, for TOI {} , for transmission", packet->size(), symbols.size(), file->meta().toi );
 
-          _socket.async_send_to(
-              boost::asio::buffer(packet->data(), packet->size()), _endpoint,
-              [file, symbols, packet, this](
-                const boost::system::error_code& error,
-                std::size_t/* bytes_transferred*/)
-              {
-                if (error) {
-                  spdlog::debug("send_to error: {}", error.message());
-                } else {
-                  file->mark_completed(symbols, !error);
-                  if (file->complete()) {
-                    file_transmitted(file->meta().toi);
-                  }
+          if (_pcap_writer) {
+            _pcap_writer->write(packet->data(), packet->size(), _record_only ? _record_time_us :
+                std::chrono::duration_cast<std::chrono::microseconds>(
+                  _clock->system_now().time_since_epoch()).count());
+          }
+
+          _counters_sequence.write_begin();
+          _counters.queued.add();
+          if (_record_only) {
+            _counters.packets.add();
+            _counters.bytes.add(packet->size());
+          }
+          _counters_sequence.write_end();
+
+          if (_record_only) {
+            file->mark_completed(symbols, true);
+            if (file->complete()) {
+              file_transmitted(file->meta().toi);
+            }
+          } else {
+            auto sent = [file, symbols, packet, this](const boost::system::error_code& error) {
+              _counters_sequence.write_begin();
+              if (error) {
+                _counters.send_errors.add();
+              } else {
+                _counters.packets.add();
+                _counters.bytes.add(packet->size());
+              }
+              _counters_sequence.write_end();
+
+              if (error) {
+                spdlog::debug("send_to error: {}", error.message());
+              } else {
+                file->mark_completed(symbols, !error);
+                if (file->complete()) {
+                  file_transmitted(file->meta().toi);
                 }
+              }
+            };
+            if (_transport) {
+              // the file bookkeeping and the counters belong to the io_service thread
+              _transport->async_send(packet->data(), packet->size(), [this, sent](const boost::system::error_code& error) {
+                  boost::asio::dispatch(_io_service, [sent, error]() { sent(error); });
               });
+            } else {
+              _socket.async_send_to(
+                  boost::asio::buffer(packet->data(), packet->size()), _endpoint,
+                  [sent](const boost::system::error_code& error, std::size_t/* bytes_transferred*/) {
+                    sent(error);
+                  });
+            }
+          }
         } 
         break;
       }
     }
   } 
-  if (bytes_queued != 0U) {
-    _send_timer.expires_from_now(boost::posix_time::milliseconds(10));
-    _send_timer.async_wait( boost::bind(&Transmitter::send_next_packet, this)); //NOLINT
+  _counters_sequence.write_begin();
+  _counters.files_queued.set(_files.size() - _files.count(0));
+  _counters_sequence.write_end();
+
+  if (_record_only) {
+    // no socket to wait for: advance the recording clock by the pacing interval and continue
+    // immediately, or idle until there is something to send
+    if (bytes_queued == 0U) {
+      _send_timer->expires_after(std::chrono::milliseconds(10));
+      _send_timer->async_wait( boost::bind(&Transmitter::send_next_packet, this)); //NOLINT
+    } else {
+      if (_rate_limit != 0) {
+        _record_time_us += (static_cast<uint64_t>(bytes_queued) * 8000U) / _rate_limit;
+      }
+      _io_service.post(boost::bind(&Transmitter::send_next_packet, this)); //NOLINT
+    }
+  } else if (bytes_queued == 0U) {
+    // nothing to send, check again later
+    _send_timer->expires_after(std::chrono::milliseconds(10));
+    _send_timer->async_wait( boost::bind(&Transmitter::send_next_packet, this)); //NOLINT
   } else {
     if (_rate_limit == 0) {
       _io_service.post(boost::bind(&Transmitter::send_next_packet, this)); //NOLINT
@@ -219,9 +315,9 @@ auto LibFlute::Transmitter::send_next_packet() -> void
       auto send_duration = ((bytes_queued * 8.0) / (double)_rate_limit/1000.0) * 1000.0 * 1000.0;
       spdlog::debug("Rate limiter: queued {} bytes, limit {} kbps, next send in {} us", 
           bytes_queued, _rate_limit, send_duration);
-      _send_timer.expires_from_now(boost::posix_time::microseconds(
-            static_cast<int>(ceil(send_duration))));
-      _send_timer.async_wait( boost::bind(&Transmitter::send_next_packet, this)); //NOLINT
+      _next_send_time = _clock->now() + std::chrono::microseconds(static_cast<int>(ceil(send_duration)));
+      _send_timer->expires_at(_next_send_time);
+      _send_timer->async_wait( boost::bind(&Transmitter::send_next_packet, this)); //NOLINT
     }
   }
 }
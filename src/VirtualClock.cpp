@@ -0,0 +1,112 @@
+// libflute - FLUTE/ALC library
+//
+// Copyright (C) 2021 Klaus Kühnhammer (Österreichische Rundfunksender GmbH & Co KG)
+//
+// Licensed under the License terms and conditions for use, reproduction, and
+// distribution of 5G-MAG software (the “License”).  You may not use this file
+// except in compliance with the License.  You may obtain a copy of the License at
+// https://www.5g-mag.com/reference-tools.  Unless required by applicable law or
+// agreed to in writing, software distributed under the License is distributed on
+// an “AS IS” BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express
+// or implied.
+//
+// See the License for the specific language governing permissions and limitations
+// under the License.
+//
+#include "VirtualClock.h"
+#include <algorithm>                                                // for max
+#include <vector>                                                   // for vector
+
+class LibFlute::VirtualClock::VirtualTimer : public Timer {
+  public:
+    VirtualTimer(VirtualClock& clock, boost::asio::io_service& io_service)
+      : _clock(clock)
+      , _io_service(io_service) {};
+    ~VirtualTimer() override { _clock.cancel(this, false); };
+
+    void expires_at(time_point expiry) override {
+      _clock.cancel(this, true);
+      _expiry = expiry;
+    };
+    void expires_after(duration delay) override { expires_at(_clock.now() + delay); };
+    void async_wait(handler_t handler) override { _clock.schedule(_expiry, this, std::move(handler)); };
+    void cancel() override { _clock.cancel(this, true); };
+
+    boost::asio::io_service& io_service() { return _io_service; };
+
+  private:
+    VirtualClock& _clock;
+    boost::asio::io_service& _io_service;
+    time_point _expiry = {};
+};
+
+LibFlute::VirtualClock::VirtualClock(std::chrono::system_clock::time_point start)
+  : _start(start)
+{
+}
+
+auto LibFlute::VirtualClock::system_now() -> std::chrono::system_clock::time_point
+{
+  return _start + std::chrono::duration_cast<std::chrono::system_clock::duration>(_now - time_point());
+}
+
+auto LibFlute::VirtualClock::make_timer(boost::asio::io_service& io_service) -> std::unique_ptr<Timer>
+{
+  return std::make_unique<VirtualTimer>(*this, io_service);
+}
+
+auto LibFlute::VirtualClock::schedule(time_point expiry, VirtualTimer* timer, Timer::handler_t handler,
+    boost::system::error_code error) -> void
+{
+  _waits.emplace(std::make_pair(expiry, _sequence++), Wait{timer, std::move(handler), error});
+}
+
+auto LibFlute::VirtualClock::cancel(VirtualTimer* timer, bool notify) -> void
+{
+  // like asio, cancelled waits complete with operation_aborted. Waits of destroyed timers are dropped,
+  // as their handlers usually refer to the timer's owner.
+  std::vector<Timer::handler_t> aborted;
+  for (auto it = _waits.begin(); it != _waits.end();) {
+    if (it->second.timer == timer) {
+      aborted.push_back(std::move(it->second.handler));
+      it = _waits.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  if (notify) {
+    for (auto& handler : aborted) {
+      schedule(_now, timer, std::move(handler), boost::asio::error::operation_aborted);
+    }
+  }
+}
+
+auto LibFlute::VirtualClock::fire_next(time_point limit) -> bool
+{
+  if (_waits.empty() || _waits.begin()->first.first > limit) {
+    return false;
+  }
+  auto wait = std::move(_waits.begin()->second);
+  _now = std::max(_now, _waits.begin()->first.first);
+  _waits.erase(_waits.begin());
+  boost::asio::post(wait.timer->io_service(), [handler = std::move(wait.handler), error = wait.error]() {
+      handler(error);
+  });
+  return true;
+}
+
+auto LibFlute::VirtualClock::run_for(boost::asio::io_service& io_service, duration duration) -> size_t
+{
+  auto end = _now + duration;
+  size_t expiries = 0;
+  for (;;) {
+    io_service.restart();
+    io_service.poll();
+    if (!fire_next(end)) {
+      break;
+    }
+    expiries++;
+  }
+  _now = end;
+  return expiries;
+}
@@ -279,6 +279,33 @@ bool LibFlute::RaptorFEC::parse_fdt_info(tinyxml2::XMLElement *file) {
   N  = (uint8_t)scheme_specific_info[2];
   Al = (uint8_t)scheme_specific_info[3];
   
+  init_decoder();
+  return true;
+}
+
+bool LibFlute::RaptorFEC::parse_fec_oti(const FecOti& fec_oti) {
+  is_encoder = false;
+
+  F = fec_oti.transfer_length;
+  T = fec_oti.encoding_symbol_length;
+
+  if (fec_oti.scheme_specific_info.length() != 4) {
+    throw "Missing or malformed scheme specific info for Raptor FEC";
+  }
+
+  Z  = (uint8_t)fec_oti.scheme_specific_info[0] << 8;
+  Z |= (uint8_t)fec_oti.scheme_specific_info[1];
+  N  = (uint8_t)fec_oti.scheme_specific_info[2];
+  Al = (uint8_t)fec_oti.scheme_specific_info[3];
+
+  init_decoder();
+  return true;
+}
+
+void LibFlute::RaptorFEC::init_decoder() {
+  if (T == 0 || Al == 0 || Z == 0) {
+    throw "Invalid Raptor FEC OTI from sender";
+  }
   if (T % Al) {
     throw "Symbol size T is not a multiple of Al. Invalid configuration from sender";
   }
@@ -292,8 +319,15 @@ bool LibFlute::RaptorFEC::parse_fdt_info(tinyxml2::XMLElement *file) {
   small_source_block_length = (Z * K - nof_source_symbols) * T;
   nof_large_source_blocks = 0;
   large_source_block_length = 0;
+}
 
-  return true;
+std::string LibFlute::RaptorFEC::scheme_specific_info() const {
+  std::string ssi(4, '\0');
+  ssi[0] = (char)((Z >> 8) & 0xFF);
+  ssi[1] = (char)(Z & 0xFF);
+  ssi[2] = (char)(N & 0xFF);
+  ssi[3] = (char)(Al & 0xFF);
+  return ssi;
 }
 
 bool LibFlute::RaptorFEC::add_fdt_info(tinyxml2::XMLElement *file) {
@@ -304,6 +338,7 @@ bool LibFlute::RaptorFEC::add_fdt_info(tinyxml2::XMLElement *file) {
   file->SetAttribute("FEC-OTI-Number-Of-Source-Blocks", Z);
   file->SetAttribute("FEC-OTI-Number-Of-Sub-Blocks", N);
   file->SetAttribute("FEC-OTI-Symbol-Alignment-Parameter", Al);
+  file->SetAttribute("FEC-OTI-Scheme-Specific-Info", base64_encode(scheme_specific_info()).c_str());
 
   is_encoder = true;
 